@@ -0,0 +1,4 @@
+# Loaded by FindLB/utf.cmake from an installed version
+# LB::utf links to Threads::Threads, which has to exist before the exported targets are loaded
+find_package(Threads REQUIRED)
+include("${CMAKE_CURRENT_LIST_DIR}/utf-targets.cmake")
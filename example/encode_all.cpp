@@ -1,4 +1,4 @@
-#include "utf.hpp"
+#include "stream.hpp"
 
 #include <cstdint>
 #include <cstdlib>
@@ -11,12 +11,32 @@ int main()
 {
 	if(std::ofstream out {"encode_all.txt", std::ios::out|std::ios::binary|std::ios::trunc})
 	{
+		auto writer = LB::utf::make_writer(out);
 		for(std::uint32_t cp = 0; cp <= 0x10FFFF; ++cp)
 		{
-			out << cp << ": \"" << LB::utf::encode_code_point<char>(cp) << "\"\n";
+			//format the number without going through the stream
+			char digits[10];
+			char *first = digits + sizeof(digits);
+			std::uint32_t v = cp;
+			do
+			{
+				*--first = static_cast<char>('0' + v%10);
+				v /= 10;
+			}
+			while(v);
+			writer.write_code_units(first, digits + sizeof(digits));
+
+			static constexpr char open[] = {':', ' ', '"'};
+			static constexpr char close[] = {'"', '\n'};
+			writer.write_code_units(std::begin(open), std::end(open));
+			writer.write(cp);
+			writer.write_code_units(std::begin(close), std::end(close));
 		}
 
-		return EXIT_SUCCESS;
+		if(writer.flush())
+		{
+			return EXIT_SUCCESS;
+		}
 	}
 	return EXIT_FAILURE;
 }
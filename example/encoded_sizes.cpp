@@ -0,0 +1,62 @@
+#include "transcode.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+/**
+ * Give UTF-8 filenames for the size of each file at every code unit width
+ */
+int main(int nargs, char const *const *args)
+{
+	if(nargs < 2)
+	{
+		std::cerr << "Please pass one or more filenames as arguments" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int status = EXIT_SUCCESS;
+	for(int i = 1; i < nargs; ++i)
+	{
+		std::ifstream in {args[i], std::ios::in|std::ios::binary};
+		if(!in)
+		{
+			std::cerr << "Cannot find file: " << args[i] << std::endl;
+			status = EXIT_FAILURE;
+			continue;
+		}
+		std::vector<char> const data {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+		//one pass over the file measures every width
+		auto const sizes = LB::utf::encoded_sizes(data.data(), data.data() + data.size());
+		auto const valid = static_cast<std::size_t>(LB::utf::validate(data.data(), data.data() + data.size()) - data.data());
+		std::size_t const bytes[] = {sizes.units8, sizes.units16*2, sizes.units32*4, sizes.units64*8};
+		std::size_t smallest = 0;
+		for(std::size_t w = 1; w < 4; ++w)
+		{
+			if(bytes[w] < bytes[smallest])
+			{
+				smallest = w;
+			}
+		}
+
+		std::cout << args[i] << '\n';
+		if(valid != data.size())
+		{
+			std::cout << "  Invalid sequence at code unit " << valid << ", only the code units before it are measured" << '\n';
+			status = EXIT_FAILURE;
+		}
+		for(std::size_t w = 0; w < 4; ++w)
+		{
+			std::cout
+				<< "  " << (8 << w) << "-bit code units: " << bytes[w] << " bytes"
+				<< (w == smallest? " (smallest)" : "")
+				<< '\n';
+		}
+	}
+	std::cout << std::flush;
+	return status;
+}
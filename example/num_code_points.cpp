@@ -1,13 +1,9 @@
-#include "utf.hpp"
+#include "stream.hpp"
 
 #include <cstdint>
 #include <cstdlib>
-#include <functional>
 #include <fstream>
 #include <iostream>
-#include <iterator>
-#include <string>
-#include <utility>
 
 /**
  * Give a UTF-8 filename for a count of valid code points and invalid code units
@@ -19,38 +15,32 @@ int main(int nargs, char const *const *args)
 		std::cerr << "Please pass the filename as an argument" << std::endl;
 		return EXIT_FAILURE;
 	}
-	std::string const utf_string = [&]
+	std::ifstream in {args[1], std::ios::in|std::ios::binary};
+	if(!in)
 	{
-		if(std::ifstream in {args[1], std::ios::in|std::ios::binary})
-		{
-			return std::string(std::istreambuf_iterator<char>(in), {});
-		}
 		std::cerr << "Cannot find file: " << args[1] << std::endl;
-		std::exit(EXIT_FAILURE);
-	}();
+		return EXIT_FAILURE;
+	}
 
-	std::size_t valid = 0
-	,           invalid = 0;
-	for(auto it = std::cbegin(utf_string), end = std::cend(utf_string); it != end; )
+	//the file is decoded in blocks, so it never has to fit in memory
+	auto reader = LB::utf::make_reader(in);
+	std::uintmax_t valid = 0
+	,              invalid = 0;
+	while(!reader.eof())
 	{
 		std::uint32_t cp {};
-		std::size_t num_code_units {};
-		auto r = std::make_pair(std::ref(it), std::ref(num_code_units));
-		r = LB::utf::read_code_point(it, end, cp);
-
-		if(num_code_units)
+		if(reader.read(cp))
 		{
 			++valid;
 		}
 		else
 		{
 			++invalid;
-			++it;
 		}
 	}
 
 	std::cout
-		<< "Number of original code units: " << utf_string.size()
+		<< "Number of original code units: " << reader.code_units_read()
 		<< '\n'
 		<< "Number of valid code points: " << valid
 		<< '\n'
@@ -0,0 +1,122 @@
+#ifndef LB_utf_advance_HeaderPlusPlus
+#define LB_utf_advance_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//code units counted per kernel call before falling back to a scalar scan for the exact position
+			constexpr std::size_t advance_block_size = 256;
+
+			template<typename code_unit_iterator>
+			auto advance(code_unit_iterator &it, code_unit_iterator const last, std::size_t n, std::true_type) noexcept
+			-> std::size_t
+			{
+				if(!n || it == last)
+				{
+					return n;
+				}
+				unsigned char const *const p = to_bytes(it);
+				std::size_t const size = static_cast<std::size_t>(last - it);
+				auto const &k = byte_kernels();
+				//the first code unit always starts the first code point, so the nth boundary is the nth lead after it
+				std::size_t i = 1;
+				for(; size - i >= advance_block_size; i += advance_block_size)
+				{
+					std::size_t const leads = k.count_leads(p + i, advance_block_size);
+					if(leads >= n)
+					{
+						break;
+					}
+					n -= leads;
+				}
+				for(; i < size; ++i)
+				{
+					if(!is_continuation(p[i]) && !--n)
+					{
+						it += static_cast<std::ptrdiff_t>(i);
+						return 0;
+					}
+				}
+				it = last;
+				return n - 1;
+			}
+			template<typename code_unit_iterator>
+			auto advance(code_unit_iterator &it, code_unit_iterator const last, std::size_t n, std::false_type)
+			-> std::size_t
+			{
+				for(; n && it != last; --n)
+				{
+					do
+					{
+						++it;
+					}
+					while(it != last && is_continuation(*it));
+				}
+				return n;
+			}
+
+			template<typename code_unit_iterator>
+			auto distance(code_unit_iterator const first, code_unit_iterator const last, std::true_type) noexcept
+			-> std::size_t
+			{
+				if(first == last)
+				{
+					return 0;
+				}
+				return 1 + byte_kernels().count_leads(to_bytes(first) + 1, static_cast<std::size_t>(last - first) - 1);
+			}
+			template<typename code_unit_iterator>
+			auto distance(code_unit_iterator first, code_unit_iterator const last, std::false_type)
+			-> std::size_t
+			{
+				std::size_t n = 0;
+				for(; first != last; ++n)
+				{
+					do
+					{
+						++first;
+					}
+					while(first != last && is_continuation(*first));
+				}
+				return n;
+			}
+		}
+
+		//moves it forward by n code points without decoding them, stopping at last
+		//returns how many of the n code points could not be skipped because last was reached first
+		template<typename code_unit_iterator>
+		auto advance(code_unit_iterator &it, code_unit_iterator const last, std::size_t const n)
+		-> std::size_t
+		{
+			return detail::advance(it, last, n, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+
+		template<typename code_unit_iterator>
+		auto next(code_unit_iterator it, code_unit_iterator const last, std::size_t const n = 1)
+		-> code_unit_iterator
+		{
+			advance(it, last, n);
+			return it;
+		}
+
+		//the number of code points between first and last, such that advance(first, last, distance(first, last)) reaches last
+		template<typename code_unit_iterator>
+		auto distance(code_unit_iterator const first, code_unit_iterator const last)
+		-> std::size_t
+		{
+			return detail::distance(first, last, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef LB_utf_batch_HeaderPlusPlus
+#define LB_utf_batch_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "transcode.hpp"
+#include "utf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		//what decode_batch found in one string
+		struct batch_string final
+		{
+			//number of code points written for the string
+			std::size_t code_points;
+			//number of code units before the first invalid sequence, the length of the string if there was none
+			std::size_t valid_units;
+		};
+
+		namespace detail
+		{
+			//calls f(first, last, ascii) for each string [data + offsets[i], data + offsets[i+1])
+			//ascii is true if the string is known to contain only ASCII, which is found with one bulk scan across string boundaries
+			template<typename code_unit_iterator, typename offset_iterator, typename function_t>
+			void for_each_string(code_unit_iterator const data, offset_iterator offsets_first, offset_iterator const offsets_last, function_t &&f, std::true_type)
+			{
+				if(offsets_first == offsets_last)
+				{
+					return;
+				}
+				auto const &k = byte_kernels();
+				unsigned char const *const p = to_bytes(data);
+				std::size_t const end = static_cast<std::size_t>(offsets_last[-1]);
+				std::size_t start = static_cast<std::size_t>(*offsets_first)
+				,           ascii_end = start; //[start, ascii_end) is known to be ASCII
+				for(++offsets_first; offsets_first != offsets_last; ++offsets_first)
+				{
+					std::size_t const stop = static_cast<std::size_t>(*offsets_first);
+					if(ascii_end < stop && ascii_end == start)
+					{
+						//only rescan once the previous run has been used up, so each code unit is scanned once
+						ascii_end = start + k.ascii_prefix(p + start, end - start);
+					}
+					f(data + static_cast<std::ptrdiff_t>(start), data + static_cast<std::ptrdiff_t>(stop), stop <= ascii_end);
+					if(ascii_end < stop)
+					{
+						ascii_end = stop;
+					}
+					start = stop;
+				}
+			}
+			template<typename code_unit_iterator, typename offset_iterator, typename function_t>
+			void for_each_string(code_unit_iterator const data, offset_iterator offsets_first, offset_iterator const offsets_last, function_t &&f, std::false_type)
+			{
+				if(offsets_first == offsets_last)
+				{
+					return;
+				}
+				auto start = *offsets_first;
+				for(++offsets_first; offsets_first != offsets_last; ++offsets_first)
+				{
+					auto const stop = *offsets_first;
+					f(std::next(data, static_cast<std::ptrdiff_t>(start)), std::next(data, static_cast<std::ptrdiff_t>(stop)), false);
+					start = stop;
+				}
+			}
+
+			template<typename code_unit_iterator, typename offset_iterator, typename function_t>
+			void for_each_string(code_unit_iterator const data, offset_iterator const offsets_first, offset_iterator const offsets_last, function_t &&f)
+			{
+				for_each_string(data, offsets_first, offsets_last, f, uses_byte_kernels<code_unit_iterator>{});
+			}
+		}
+
+		//validates every string of a column, where string i is [data + offsets[i], data + offsets[i+1])
+		//writes the number of code units before the first invalid sequence of each string to out, and returns how many strings were invalid
+		template<typename code_unit_iterator, typename offset_iterator, typename output_iterator>
+		auto validate_batch(code_unit_iterator const data, offset_iterator const offsets_first, offset_iterator const offsets_last, output_iterator out)
+		-> std::size_t
+		{
+			std::size_t invalid = 0;
+			detail::for_each_string(data, offsets_first, offsets_last, [&](code_unit_iterator const first, code_unit_iterator const last, bool const ascii)
+			{
+				std::size_t const length = static_cast<std::size_t>(std::distance(first, last));
+				std::size_t const valid = ascii? length : static_cast<std::size_t>(std::distance(first, validate(first, last)));
+				invalid += (valid != length);
+				*out = valid;
+				++out;
+			});
+			return invalid;
+		}
+
+		//counts the code points of every string of a column like count_code_points, writing each count to out
+		//returns the total, which is how many code points decode_batch writes if every string is valid
+		template<typename code_unit_iterator, typename offset_iterator, typename output_iterator>
+		auto count_code_points_batch(code_unit_iterator const data, offset_iterator const offsets_first, offset_iterator const offsets_last, output_iterator out)
+		-> std::size_t
+		{
+			std::size_t total = 0;
+			detail::for_each_string(data, offsets_first, offsets_last, [&](code_unit_iterator const first, code_unit_iterator const last, bool const ascii)
+			{
+				std::size_t const n = ascii? static_cast<std::size_t>(std::distance(first, last)) : count_code_points(first, last);
+				total += n;
+				*out = n;
+				++out;
+			});
+			return total;
+		}
+
+		//decodes every string of a column into one sequence of code points, writing a batch_string for each string to strings
+		//a string is decoded up to its first invalid sequence, returns one past the last code point written
+		template<typename code_point_t = std::uintmax_t, typename code_unit_iterator, typename offset_iterator, typename output_iterator, typename string_output_iterator>
+		auto decode_batch(code_unit_iterator const data, offset_iterator const offsets_first, offset_iterator const offsets_last, output_iterator out, string_output_iterator strings)
+		-> output_iterator
+		{
+			using kernels_tag = detail::uses_byte_kernels<code_unit_iterator>;
+			using copy_tag = detail::is_unit_pointer<output_iterator, 4>;
+			detail::for_each_string(data, offsets_first, offsets_last, [&](code_unit_iterator it, code_unit_iterator const last, bool const ascii)
+			{
+				code_unit_iterator const first = it;
+				std::size_t count = 0;
+				if(ascii)
+				{
+					//already scanned, so short strings do not pay for another kernel call
+					for(; it != last; ++it, ++out, ++count)
+					{
+						*out = static_cast<code_point_t>(*it);
+					}
+				}
+				bool after_ascii = true;
+				while(it != last)
+				{
+					if(after_ascii && kernels_tag::value)
+					{
+						std::size_t const n = detail::copy_ascii<code_point_t>(it, last, out, kernels_tag{}, copy_tag{});
+						std::advance(it, n);
+						count += n;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					code_point_t cp {};
+					auto const r = read_code_point(it, last, cp);
+					if(!r.second)
+					{
+						break;
+					}
+					it = r.first;
+					*out = cp;
+					++out;
+					++count;
+					after_ascii = cp < 0x80u;
+				}
+				*strings = batch_string{count, static_cast<std::size_t>(std::distance(first, it))};
+				++strings;
+			});
+			return out;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef LB_utf_buffer_HeaderPlusPlus
+#define LB_utf_buffer_HeaderPlusPlus
+
+#include "utf.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		//contiguous code units followed by at least padding zeroed code units,
+		//so they can be decoded with the unchecked functions and read past the end by vector loads
+		template<typename code_unit_t, std::size_t padding = 64>
+		class padded_buffer final
+		{
+			std::vector<code_unit_t> storage;
+			std::size_t n = 0;
+
+		public:
+			static constexpr std::size_t padding_size = padding;
+
+			padded_buffer()
+			: storage(padding)
+			{
+			}
+			explicit padded_buffer(std::size_t const size)
+			: storage(size + padding)
+			, n(size)
+			{
+			}
+			template<typename code_unit_iterator>
+			padded_buffer(code_unit_iterator first, code_unit_iterator const last)
+			{
+				assign(first, last);
+			}
+
+			template<typename code_unit_iterator>
+			void assign(code_unit_iterator first, code_unit_iterator const last)
+			{
+				storage.assign(first, last);
+				n = storage.size();
+				storage.resize(n + padding);
+			}
+
+			//new code units are zeroed, as is the padding after shrinking
+			void resize(std::size_t const size)
+			{
+				storage.resize(size + padding);
+				if(size < n)
+				{
+					std::fill(storage.begin() + static_cast<std::ptrdiff_t>(size), storage.end(), code_unit_t{});
+				}
+				n = size;
+			}
+
+			auto data() noexcept
+			-> code_unit_t *
+			{
+				return storage.data();
+			}
+			auto data() const noexcept
+			-> code_unit_t const *
+			{
+				return storage.data();
+			}
+			auto size() const noexcept
+			-> std::size_t
+			{
+				return n;
+			}
+			auto begin() noexcept
+			-> code_unit_t *
+			{
+				return data();
+			}
+			auto begin() const noexcept
+			-> code_unit_t const *
+			{
+				return data();
+			}
+			auto end() noexcept
+			-> code_unit_t *
+			{
+				return data() + n;
+			}
+			auto end() const noexcept
+			-> code_unit_t const *
+			{
+				return data() + n;
+			}
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef LB_utf_compact_string_HeaderPlusPlus
+#define LB_utf_compact_string_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "transcode.hpp"
+#include "utf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		//decoded code points stored with a fixed width of 1, 2, 4, or 8 bytes chosen from the largest one,
+		//so they can be indexed in constant time without always paying for the widest storage
+		class compact_string final
+		{
+		public:
+			using value_type = std::uint64_t;
+
+		private:
+			std::vector<unsigned char> storage;
+			std::size_t n = 0
+			,           w = 1;
+
+			template<typename unit_t>
+			auto load(std::size_t const i) const noexcept
+			-> value_type
+			{
+				unit_t v;
+				std::memcpy(&v, storage.data() + i*sizeof(unit_t), sizeof(unit_t));
+				return v;
+			}
+			template<typename unit_t>
+			void store(std::size_t const i, value_type const cp) noexcept
+			{
+				unit_t const v = static_cast<unit_t>(cp);
+				std::memcpy(storage.data() + i*sizeof(unit_t), &v, sizeof(unit_t));
+			}
+			void store(std::size_t const i, value_type const cp) noexcept
+			{
+				switch(w)
+				{
+					case 1: return store<std::uint8_t>(i, cp);
+					case 2: return store<std::uint16_t>(i, cp);
+					case 4: return store<std::uint32_t>(i, cp);
+					default: return store<std::uint64_t>(i, cp);
+				}
+			}
+
+			//copies a run of ASCII code units to the storage starting at code point i
+			template<typename code_unit_iterator>
+			void copy_ascii(code_unit_iterator const it, std::size_t const i, std::size_t const count, std::true_type) noexcept
+			{
+				unsigned char const *const p = detail::to_bytes(it);
+				switch(w)
+				{
+					case 1:
+					{
+						std::memcpy(storage.data() + i, p, count);
+						break;
+					}
+					case 4:
+					{
+						detail::widen_ascii(p, count, static_cast<void *>(storage.data() + i*sizeof(std::uint32_t)), std::false_type{});
+						break;
+					}
+					default:
+					{
+						for(std::size_t j = 0; j < count; ++j)
+						{
+							store(i + j, p[j]);
+						}
+					}
+				}
+			}
+			template<typename code_unit_iterator>
+			void copy_ascii(code_unit_iterator const, std::size_t const, std::size_t const, std::false_type) noexcept
+			{
+			}
+
+			static auto width_for(value_type const max) noexcept
+			-> std::size_t
+			{
+				return (max <= 0xFFu)? 1 : (max <= 0xFFFFu)? 2 : (max <= 0xFFFFFFFFu)? 4 : 8;
+			}
+
+		public:
+			compact_string() = default;
+
+			//decodes the code units, throws std::invalid_argument if they are invalid
+			//code points must fit in 64 bits
+			template<typename code_unit_iterator>
+			compact_string(code_unit_iterator const first, code_unit_iterator const last)
+			{
+				using byte_input = detail::uses_byte_kernels<code_unit_iterator>;
+				//scan for the number of code points and the largest one, skipping runs of ASCII in bulk
+				value_type max = 0;
+				bool ascii = true;
+				for(code_unit_iterator it = first; it != last;)
+				{
+					if(ascii)
+					{
+						std::size_t const run = detail::ascii_run(it, last, byte_input{});
+						if(run)
+						{
+							std::advance(it, run);
+							n += run;
+							if(it == last)
+							{
+								break;
+							}
+						}
+					}
+					value_type cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second)
+					{
+						throw std::invalid_argument("invalid UTF sequence");
+					}
+					it = r.first;
+					++n;
+					max = (max < cp)? cp : max;
+					ascii = cp < 0x80u;
+				}
+				w = width_for(max);
+				storage.resize(n*w);
+
+				std::size_t i = 0;
+				ascii = true;
+				for(code_unit_iterator it = first; it != last;)
+				{
+					if(ascii)
+					{
+						std::size_t const run = detail::ascii_run(it, last, byte_input{});
+						copy_ascii(it, i, run, byte_input{});
+						std::advance(it, run);
+						i += run;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					value_type cp {};
+					it = utf::read_code_point(it, last, cp).first;
+					store(i++, cp);
+					ascii = cp < 0x80u;
+				}
+			}
+
+			//the number of code points
+			auto size() const noexcept
+			-> std::size_t
+			{
+				return n;
+			}
+			auto empty() const noexcept
+			-> bool
+			{
+				return !n;
+			}
+			//the number of bytes used for each code point: 1, 2, 4, or 8
+			auto width() const noexcept
+			-> std::size_t
+			{
+				return w;
+			}
+
+			auto operator[](std::size_t const i) const noexcept
+			-> value_type
+			{
+				switch(w)
+				{
+					case 1: return load<std::uint8_t>(i);
+					case 2: return load<std::uint16_t>(i);
+					case 4: return load<std::uint32_t>(i);
+					default: return load<std::uint64_t>(i);
+				}
+			}
+			auto at(std::size_t const i) const
+			-> value_type
+			{
+				if(i >= n)
+				{
+					throw std::out_of_range("compact_string index out of range");
+				}
+				return (*this)[i];
+			}
+
+			//encodes every code point like encode_code_point, returns the iterator after the last code unit written
+			template<typename code_unit_t, typename code_unit_output_iterator>
+			auto encode(code_unit_output_iterator out) const
+			-> code_unit_output_iterator
+			{
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					out = encode_code_point<code_unit_t>((*this)[i], out);
+				}
+				return out;
+			}
+			//encodes into a string allocated once with the exact size
+			template<typename code_unit_t = char>
+			auto encode() const
+			-> std::basic_string<code_unit_t>
+			{
+				std::size_t size = 0;
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					size += min_code_units<code_unit_t>((*this)[i]);
+				}
+				std::basic_string<code_unit_t> str (size, code_unit_t{});
+				code_unit_t *out = &str[0];
+				bool ascii = true;
+				for(std::size_t i = 0; i < n;)
+				{
+					if(ascii && sizeof(code_unit_t) == 1 && (w == 1 || w == 4))
+					{
+						//runs of ASCII copy or narrow straight back to 8-bit code units
+						auto const &k = detail::byte_kernels();
+						std::size_t const run = (w == 1)? k.ascii_prefix(storage.data() + i, n - i) : detail::narrow_ascii(static_cast<void const *>(storage.data() + i*sizeof(std::uint32_t)), n - i, reinterpret_cast<unsigned char *>(out), std::false_type{});
+						if(w == 1)
+						{
+							std::memcpy(out, storage.data() + i, run);
+						}
+						i += run;
+						out += run;
+						if(i == n)
+						{
+							break;
+						}
+					}
+					value_type const cp = (*this)[i++];
+					out = encode_code_point<code_unit_t>(cp, out);
+					ascii = cp < 0x80u;
+				}
+				return str;
+			}
+
+			friend auto operator==(compact_string const &a, compact_string const &b) noexcept
+			-> bool
+			{
+				//the width only depends on the largest code point, so equal strings always have the same width
+				return a.w == b.w && a.storage == b.storage;
+			}
+			friend auto operator!=(compact_string const &a, compact_string const &b) noexcept
+			-> bool
+			{
+				return !(a == b);
+			}
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef LB_utf_compare_HeaderPlusPlus
+#define LB_utf_compare_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//a decoded code point, or the value of the first code unit of an invalid sequence
+			struct decoded final
+			{
+				std::uintmax_t value;
+				bool invalid;
+			};
+
+			//decodes the sequence at it and moves past it, an invalid sequence only moves past one code unit
+			template<typename code_unit_iterator>
+			auto decode_next(code_unit_iterator &it, code_unit_iterator const last)
+			-> decoded
+			{
+				std::uintmax_t cp {};
+				auto const r = utf::read_code_point(it, last, cp);
+				if(!r.second)
+				{
+					decoded const d {static_cast<unsigned_code_unit_t<code_unit_iterator>>(*it), true};
+					++it;
+					return d;
+				}
+				it = r.first;
+				return decoded {cp, false};
+			}
+
+			//invalid sequences order after every code point
+			inline auto compare(decoded const &a, decoded const &b) noexcept
+			-> int
+			{
+				if(a.invalid != b.invalid)
+				{
+					return a.invalid? 1 : -1;
+				}
+				return (a.value < b.value)? -1 : (b.value < a.value)? 1 : 0;
+			}
+
+			//moves both past their common prefix of ASCII code units, as far as the bulk kernels can find it
+			template<typename iterator1, typename iterator2>
+			void skip_equal_ascii(iterator1 &it1, iterator1 const last1, iterator2 &it2, iterator2 const last2, std::true_type, std::true_type)
+			{
+				unsigned char const *const p1 = to_bytes(it1);
+				unsigned char const *const p2 = to_bytes(it2);
+				std::size_t const n = byte_kernels().ascii_prefix(p1, static_cast<std::size_t>(std::min<std::ptrdiff_t>(last1 - it1, last2 - it2)));
+				std::size_t const equal = (std::memcmp(p1, p2, n) == 0)? n : static_cast<std::size_t>(std::mismatch(p1, p1 + n, p2).first - p1);
+				it1 += static_cast<std::ptrdiff_t>(equal);
+				it2 += static_cast<std::ptrdiff_t>(equal);
+			}
+			template<typename iterator1, typename iterator2>
+			void skip_equal_ascii(iterator1 &it1, iterator1 const last1, iterator2 &it2, iterator2 const last2, std::true_type, std::false_type)
+			{
+				unsigned char const *const p1 = to_bytes(it1);
+				std::size_t const n = byte_kernels().ascii_prefix(p1, static_cast<std::size_t>(last1 - it1));
+				std::size_t i = 0;
+				for(; i < n && it2 != last2 && static_cast<unsigned_code_unit_t<iterator2>>(*it2) == p1[i]; ++i)
+				{
+					++it2;
+				}
+				it1 += static_cast<std::ptrdiff_t>(i);
+			}
+			template<typename iterator1, typename iterator2>
+			void skip_equal_ascii(iterator1 &it1, iterator1 const last1, iterator2 &it2, iterator2 const last2, std::false_type, std::true_type)
+			{
+				skip_equal_ascii(it2, last2, it1, last1, std::true_type{}, std::false_type{});
+			}
+			template<typename iterator1, typename iterator2>
+			void skip_equal_ascii(iterator1 &, iterator1 const, iterator2 &, iterator2 const, std::false_type, std::false_type) noexcept
+			{
+			}
+
+			//the number of leading code units two contiguous strings have in common
+			template<typename code_unit_t>
+			auto common_prefix(code_unit_t const *const p1, code_unit_t const *const p2, std::size_t const n) noexcept
+			-> std::size_t
+			{
+				std::size_t i = 0;
+				//a word at a time while there is no difference
+				constexpr std::size_t step = (sizeof(std::uint64_t) > sizeof(code_unit_t))? sizeof(std::uint64_t)/sizeof(code_unit_t) : 1;
+				for(; i + step <= n && std::memcmp(p1 + i, p2 + i, step*sizeof(code_unit_t)) == 0; i += step)
+				{
+				}
+				for(; i < n && p1[i] == p2[i]; ++i)
+				{
+				}
+				return i;
+			}
+
+			constexpr std::uint64_t hash_basis = 14695981039346656037ull;
+			constexpr std::uint64_t hash_prime = 1099511628211ull;
+
+			constexpr auto hash_step(std::uint64_t const h, std::uintmax_t const value) noexcept
+			-> std::uint64_t
+			{
+				return (h ^ static_cast<std::uint64_t>(value))*hash_prime;
+			}
+
+			template<typename code_unit_iterator>
+			auto hash_ascii(std::uint64_t h, code_unit_iterator &it, code_unit_iterator const last, std::true_type) noexcept
+			-> std::uint64_t
+			{
+				unsigned char const *const p = to_bytes(it);
+				std::size_t const n = byte_kernels().ascii_prefix(p, static_cast<std::size_t>(last - it));
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					h = hash_step(h, p[i]);
+				}
+				it += static_cast<std::ptrdiff_t>(n);
+				return h;
+			}
+			template<typename code_unit_iterator>
+			constexpr auto hash_ascii(std::uint64_t const h, code_unit_iterator &, code_unit_iterator const, std::false_type) noexcept
+			-> std::uint64_t
+			{
+				return h;
+			}
+		}
+
+		//compares two encoded strings by code point order, the code unit types may differ
+		//returns a negative number, zero, or a positive number like std::strcmp
+		template<typename iterator1, typename iterator2>
+		auto compare(iterator1 first1, iterator1 const last1, iterator2 first2, iterator2 const last2)
+		-> int
+		{
+			bool ascii = true;
+			for(;;)
+			{
+				if(ascii && first1 != last1 && first2 != last2)
+				{
+					detail::skip_equal_ascii(first1, last1, first2, last2, detail::uses_byte_kernels<iterator1>{}, detail::uses_byte_kernels<iterator2>{});
+				}
+				if(first1 == last1 || first2 == last2)
+				{
+					return (first1 == last1)? (first2 == last2)? 0 : -1 : 1;
+				}
+				detail::decoded const a = detail::decode_next(first1, last1);
+				detail::decoded const b = detail::decode_next(first2, last2);
+				if(int const c = detail::compare(a, b))
+				{
+					return c;
+				}
+				//only look for another run of ASCII after an ASCII code point
+				ascii = !a.invalid && a.value < 0x80u;
+			}
+		}
+
+		namespace detail
+		{
+			//the result of compare_code_point_order from the start of a sequence they both have there
+			//byte order is only proven to be code point order when both code units are ASCII, anything else is decoded
+			template<typename code_unit_iterator>
+			auto compare_at_boundary(code_unit_iterator const it1, code_unit_iterator const last1, code_unit_iterator const it2, code_unit_iterator const last2)
+			-> int
+			{
+				if(it1 == last1 || it2 == last2)
+				{
+					return (it1 == last1)? (it2 == last2)? 0 : -1 : 1;
+				}
+				using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
+				code_unit_t const a = static_cast<code_unit_t>(*it1);
+				code_unit_t const b = static_cast<code_unit_t>(*it2);
+				if(a < 0x80u && b < 0x80u && a != b)
+				{
+					return (a < b)? -1 : 1;
+				}
+				return utf::compare(it1, last1, it2, last2);
+			}
+
+			template<typename code_unit_iterator>
+			auto compare_code_point_order(code_unit_iterator first1, code_unit_iterator const last1, code_unit_iterator first2, code_unit_iterator const last2, std::true_type)
+			-> int
+			{
+				std::size_t const n1 = static_cast<std::size_t>(last1 - first1);
+				std::size_t const n2 = static_cast<std::size_t>(last2 - first2);
+				if(!n1 || !n2)
+				{
+					return compare_at_boundary(first1, last1, first2, last2);
+				}
+				std::size_t i = common_prefix(&*first1, &*first2, std::min(n1, n2));
+				//back to the lead both strings share, everything before it is equal in both
+				while(i && ((i < n1 && is_continuation(first1[static_cast<std::ptrdiff_t>(i)])) || (i < n2 && is_continuation(first2[static_cast<std::ptrdiff_t>(i)]))))
+				{
+					--i;
+				}
+				return compare_at_boundary(first1 + static_cast<std::ptrdiff_t>(i), last1, first2 + static_cast<std::ptrdiff_t>(i), last2);
+			}
+			template<typename code_unit_iterator>
+			auto compare_code_point_order(code_unit_iterator first1, code_unit_iterator const last1, code_unit_iterator first2, code_unit_iterator const last2, std::false_type)
+			-> int
+			{
+				//remembers the last lead both strings share while walking their common prefix
+				code_unit_iterator lead1 = first1;
+				code_unit_iterator lead2 = first2;
+				for(; first1 != last1 && first2 != last2 && *first1 == *first2; ++first1, ++first2)
+				{
+					if(!is_continuation(*first1))
+					{
+						lead1 = first1;
+						lead2 = first2;
+					}
+				}
+				if((first1 == last1 || !is_continuation(*first1)) && (first2 == last2 || !is_continuation(*first2)))
+				{
+					lead1 = first1;
+					lead2 = first2;
+				}
+				return compare_at_boundary(lead1, last1, lead2, last2);
+			}
+		}
+
+		//the same result as compare for two strings with the same code unit type, found without decoding their common prefix
+		//the code units both strings share hold the same code points in both,
+		//so only the sequences where the strings first differ have to be decoded, and not even those if both are ASCII
+		template<typename code_unit_iterator>
+		auto compare_code_point_order(code_unit_iterator const first1, code_unit_iterator const last1, code_unit_iterator const first2, code_unit_iterator const last2)
+		-> int
+		{
+			return detail::compare_code_point_order(first1, last1, first2, last2, detail::is_contiguous<code_unit_iterator>{});
+		}
+
+		//whether two encoded strings have the same code points, the code unit types may differ
+		template<typename iterator1, typename iterator2>
+		auto equal(iterator1 const first1, iterator1 const last1, iterator2 const first2, iterator2 const last2)
+		-> bool
+		{
+			return compare(first1, last1, first2, last2) == 0;
+		}
+
+		//hashes the code points of an encoded string, so equal strings have the same hash whatever their code unit types
+		template<typename code_unit_iterator>
+		auto hash(code_unit_iterator first, code_unit_iterator const last)
+		-> std::uint64_t
+		{
+			std::uint64_t h = detail::hash_basis;
+			bool ascii = true;
+			while(first != last)
+			{
+				if(ascii)
+				{
+					h = detail::hash_ascii(h, first, last, detail::uses_byte_kernels<code_unit_iterator>{});
+					if(first == last)
+					{
+						break;
+					}
+				}
+				detail::decoded const d = detail::decode_next(first, last);
+				h = detail::hash_step(h, d.value);
+				if(d.invalid)
+				{
+					h = detail::hash_step(h, ~std::uintmax_t{});
+				}
+				ascii = !d.invalid && d.value < 0x80u;
+			}
+			return h;
+		}
+	}
+}
+
+#endif
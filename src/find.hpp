@@ -0,0 +1,221 @@
+#ifndef LB_utf_find_HeaderPlusPlus
+#define LB_utf_find_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//whether the needle occurs at it and ends on a sequence boundary
+			template<typename code_unit_iterator, typename needle_iterator>
+			auto matches_at(code_unit_iterator it, code_unit_iterator const last, needle_iterator needle_first, needle_iterator const needle_last)
+			-> bool
+			{
+				for(; needle_first != needle_last; ++needle_first, ++it)
+				{
+					if(it == last || !(*it == *needle_first))
+					{
+						return false;
+					}
+				}
+				return it == last || !is_continuation(*it);
+			}
+
+			//the offset of the first occurrence of the needle that ends on a sequence boundary, or n
+			inline auto find_bytes(unsigned char const *const p, std::size_t const n, unsigned char const *const needle, std::size_t const m) noexcept
+			-> std::size_t
+			{
+				auto const &k = byte_kernels();
+				//candidates must match both the first and last code units of the needle
+				for(std::size_t i = 0; i + m <= n; ++i)
+				{
+					i += k.find_pair(p + i, n - i, needle[0], needle[m-1], m-1);
+					if(i + m > n)
+					{
+						break;
+					}
+					if(std::memcmp(p + i, needle, m) == 0 && (i + m == n || !is_continuation(p[i + m])))
+					{
+						return i;
+					}
+				}
+				return n;
+			}
+			//contiguous needles are searched for in place, anything else is copied first
+			template<typename needle_iterator>
+			auto find_bytes(unsigned char const *const p, std::size_t const n, needle_iterator const needle_first, needle_iterator const needle_last, std::true_type) noexcept
+			-> std::size_t
+			{
+				return find_bytes(p, n, to_bytes(needle_first), static_cast<std::size_t>(needle_last - needle_first));
+			}
+			template<typename needle_iterator>
+			auto find_bytes(unsigned char const *const p, std::size_t const n, needle_iterator const needle_first, needle_iterator const needle_last, std::false_type)
+			-> std::size_t
+			{
+				std::vector<unsigned char> const needle (needle_first, needle_last);
+				return find_bytes(p, n, needle.data(), needle.size());
+			}
+
+			template<typename code_unit_iterator, typename needle_iterator>
+			auto find(code_unit_iterator first, code_unit_iterator const last, needle_iterator const needle_first, needle_iterator const needle_last, std::true_type)
+			-> code_unit_iterator
+			{
+				if(first == last)
+				{
+					return last;
+				}
+				std::size_t const n = static_cast<std::size_t>(last - first);
+				return first + static_cast<std::ptrdiff_t>(find_bytes(to_bytes(first), n, needle_first, needle_last, uses_byte_kernels<needle_iterator>{}));
+			}
+			template<typename code_unit_iterator, typename needle_iterator>
+			auto find(code_unit_iterator first, code_unit_iterator const last, needle_iterator const needle_first, needle_iterator const needle_last, std::false_type)
+			-> code_unit_iterator
+			{
+				auto const lead = *needle_first;
+				for(; (first = std::find(first, last, lead)) != last; ++first)
+				{
+					if(matches_at(first, last, needle_first, needle_last))
+					{
+						break;
+					}
+				}
+				return first;
+			}
+
+			//an encoded code point never starts with a continuation, so it can be searched for directly
+			//integral code points fit in a stack buffer sized for the largest of their type
+			template<typename code_unit_t, typename code_unit_iterator, typename code_point_t>
+			auto find_code_point(code_unit_iterator first, code_unit_iterator const last, code_point_t const &cp, std::true_type)
+			-> code_unit_iterator
+			{
+				std::array<code_unit_t, max_code_units_for<code_unit_t, code_point_t>()> needle;
+				code_unit_t const *const end = encode_code_point<code_unit_t>(cp, needle.data());
+				return find(first, last, static_cast<code_unit_t const *>(needle.data()), end, uses_byte_kernels<code_unit_iterator>{});
+			}
+			template<typename code_unit_t, typename code_unit_iterator, typename code_point_t>
+			auto find_code_point(code_unit_iterator first, code_unit_iterator const last, code_point_t const &cp, std::false_type)
+			-> code_unit_iterator
+			{
+				auto const needle = encode_code_point<code_unit_t>(cp);
+				return find(first, last, needle.data(), needle.data() + needle.size(), uses_byte_kernels<code_unit_iterator>{});
+			}
+
+			template<typename code_unit_iterator, typename code_unit_t>
+			auto find_any_of(code_unit_iterator first, code_unit_iterator const last, std::vector<std::basic_string<code_unit_t>> const &needles, std::true_type)
+			-> code_unit_iterator
+			{
+				if(first == last)
+				{
+					return last;
+				}
+				simd::byte_set leads {};
+				for(auto const &needle : needles)
+				{
+					leads.insert(static_cast<unsigned char>(needle.front()));
+				}
+				unsigned char const *const p = to_bytes(first);
+				std::size_t const n = static_cast<std::size_t>(last - first);
+				auto const &k = byte_kernels();
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					i += k.find_in_set(p + i, n - i, leads);
+					if(i == n)
+					{
+						break;
+					}
+					for(auto const &needle : needles)
+					{
+						if(static_cast<unsigned char>(needle.front()) == p[i]
+						&& needle.size() <= n - i
+						&& std::memcmp(p + i, needle.data(), needle.size()) == 0
+						&& (i + needle.size() == n || !is_continuation(p[i + needle.size()])))
+						{
+							return first + static_cast<std::ptrdiff_t>(i);
+						}
+					}
+				}
+				return last;
+			}
+			template<typename code_unit_iterator, typename code_unit_t>
+			auto find_any_of(code_unit_iterator first, code_unit_iterator const last, std::vector<std::basic_string<code_unit_t>> const &needles, std::false_type)
+			-> code_unit_iterator
+			{
+				for(; first != last; ++first)
+				{
+					if(is_continuation(*first))
+					{
+						continue;
+					}
+					for(auto const &needle : needles)
+					{
+						if(matches_at(first, last, std::cbegin(needle), std::cend(needle)))
+						{
+							return first;
+						}
+					}
+				}
+				return last;
+			}
+		}
+
+		//finds the first occurrence of the encoded needle that starts and ends on sequence boundaries
+		template<typename code_unit_iterator, typename needle_iterator>
+		auto find(code_unit_iterator first, code_unit_iterator const last, needle_iterator const needle_first, needle_iterator const needle_last)
+		-> code_unit_iterator
+		{
+			if(needle_first == needle_last)
+			{
+				return first;
+			}
+			if(detail::is_continuation(*needle_first))
+			{
+				//can never start on a sequence boundary
+				return last;
+			}
+			return detail::find(first, last, needle_first, needle_last, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+
+		//finds the first sequence which encodes the code point
+		template<typename code_unit_iterator, typename code_point_t>
+		auto find(code_unit_iterator first, code_unit_iterator const last, code_point_t const &cp)
+		-> code_unit_iterator
+		{
+			using code_unit_t = typename std::iterator_traits<code_unit_iterator>::value_type;
+			return detail::find_code_point<code_unit_t>(first, last, cp, std::integral_constant<bool, std::numeric_limits<code_point_t>::is_integer>{});
+		}
+
+		//finds the first sequence which encodes any of the code points
+		template<typename code_unit_iterator, typename code_point_iterator>
+		auto find_any_of(code_unit_iterator first, code_unit_iterator const last, code_point_iterator cps_first, code_point_iterator const cps_last)
+		-> code_unit_iterator
+		{
+			using code_unit_t = typename std::iterator_traits<code_unit_iterator>::value_type;
+			std::vector<std::basic_string<code_unit_t>> needles;
+			for(; cps_first != cps_last; ++cps_first)
+			{
+				needles.push_back(encode_code_point<code_unit_t>(*cps_first));
+			}
+			if(needles.empty())
+			{
+				return last;
+			}
+			return detail::find_any_of(first, last, needles, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+	}
+}
+
+#endif
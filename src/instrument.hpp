@@ -0,0 +1,190 @@
+#ifndef LB_utf_instrument_HeaderPlusPlus
+#define LB_utf_instrument_HeaderPlusPlus
+
+#include "utf.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		//plain totals, as returned by thread_local_counters::snapshot
+		struct counters final
+		{
+			//index i counts sequences of i code units, the last index counts everything longer
+			std::array<std::uint64_t, 16> sequences_by_length {};
+			std::array<std::uint64_t, 4> errors {}; //indexed by error_kind
+			std::uint64_t header_overflows {};
+			std::uint64_t fallbacks {};
+
+			auto errors_of(error_kind const kind) const noexcept
+			-> std::uint64_t
+			{
+				return errors[static_cast<std::size_t>(kind)];
+			}
+		};
+
+		//instrumentation policy which counts events per thread
+		//each thread only ever writes to its own counters, so counting is just a relaxed load and store,
+		//and snapshot() can be called from any thread (e.g. a metrics scraper) to sum every thread's counters
+		//reset() never writes to them either, it records the totals so far for snapshot() to subtract
+		struct thread_local_counters final
+		{
+			void on_sequence(std::size_t const n) const noexcept
+			{
+				auto &c = local();
+				bump(c.sequences_by_length[n < c.sequences_by_length.size()? n : c.sequences_by_length.size()-1]);
+			}
+			void on_error(error_kind const kind) const noexcept
+			{
+				bump(local().errors[static_cast<std::size_t>(kind)]);
+			}
+			void on_header_overflow(std::size_t) const noexcept
+			{
+				bump(local().header_overflows);
+			}
+			void on_fallback() const noexcept
+			{
+				bump(local().fallbacks);
+			}
+
+			//totals over all threads, including threads which have exited
+			static auto snapshot()
+			-> counters
+			{
+				auto &r = registry();
+				std::lock_guard<std::mutex> const lock {r.mutex};
+				counters total = totals(r);
+				subtract(total, r.baseline);
+				return total;
+			}
+
+			//start counting from zero again for every thread
+			static void reset()
+			{
+				auto &r = registry();
+				std::lock_guard<std::mutex> const lock {r.mutex};
+				r.baseline = totals(r);
+			}
+
+		private:
+			using counter_t = std::atomic<std::uint64_t>;
+			struct atomic_counters final
+			{
+				std::array<counter_t, std::tuple_size<decltype(counters::sequences_by_length)>::value> sequences_by_length {};
+				std::array<counter_t, std::tuple_size<decltype(counters::errors)>::value> errors {};
+				counter_t header_overflows {};
+				counter_t fallbacks {};
+
+				atomic_counters()
+				{
+					clear();
+					std::lock_guard<std::mutex> const lock {registry().mutex};
+					registry().live.push_back(this);
+				}
+				~atomic_counters()
+				{
+					auto &r = registry();
+					std::lock_guard<std::mutex> const lock {r.mutex};
+					add(r.retired, *this);
+					for(auto it = r.live.begin(); it != r.live.end(); ++it)
+					{
+						if(*it == this)
+						{
+							r.live.erase(it);
+							break;
+						}
+					}
+				}
+				atomic_counters(atomic_counters const &) = delete;
+				atomic_counters &operator=(atomic_counters const &) = delete;
+
+				void clear() noexcept
+				{
+					for(auto &v : sequences_by_length)
+					{
+						v.store(0, std::memory_order_relaxed);
+					}
+					for(auto &v : errors)
+					{
+						v.store(0, std::memory_order_relaxed);
+					}
+					header_overflows.store(0, std::memory_order_relaxed);
+					fallbacks.store(0, std::memory_order_relaxed);
+				}
+			};
+			struct registry_t final
+			{
+				std::mutex mutex;
+				std::vector<atomic_counters *> live;
+				counters retired;
+				//the totals at the last reset
+				counters baseline;
+			};
+
+			static auto registry()
+			-> registry_t &
+			{
+				static registry_t r;
+				return r;
+			}
+			static auto local()
+			-> atomic_counters &
+			{
+				thread_local atomic_counters c;
+				return c;
+			}
+
+			static void bump(counter_t &v) noexcept
+			{
+				//only the owning thread writes, so no read-modify-write is needed
+				v.store(v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+			//every count since the program started, requires the registry's mutex
+			static auto totals(registry_t const &r) noexcept
+			-> counters
+			{
+				counters total = r.retired;
+				for(auto const *const c : r.live)
+				{
+					add(total, *c);
+				}
+				return total;
+			}
+			static void subtract(counters &total, counters const &base) noexcept
+			{
+				for(std::size_t i = 0; i < total.sequences_by_length.size(); ++i)
+				{
+					total.sequences_by_length[i] -= base.sequences_by_length[i];
+				}
+				for(std::size_t i = 0; i < total.errors.size(); ++i)
+				{
+					total.errors[i] -= base.errors[i];
+				}
+				total.header_overflows -= base.header_overflows;
+				total.fallbacks -= base.fallbacks;
+			}
+			static void add(counters &total, atomic_counters const &c) noexcept
+			{
+				for(std::size_t i = 0; i < total.sequences_by_length.size(); ++i)
+				{
+					total.sequences_by_length[i] += c.sequences_by_length[i].load(std::memory_order_relaxed);
+				}
+				for(std::size_t i = 0; i < total.errors.size(); ++i)
+				{
+					total.errors[i] += c.errors[i].load(std::memory_order_relaxed);
+				}
+				total.header_overflows += c.header_overflows.load(std::memory_order_relaxed);
+				total.fallbacks += c.fallbacks.load(std::memory_order_relaxed);
+			}
+		};
+	}
+}
+
+#endif
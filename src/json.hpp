@@ -0,0 +1,399 @@
+#ifndef LB_utf_json_HeaderPlusPlus
+#define LB_utf_json_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "transcode.hpp"
+#include "utf.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		//what to do with a sequence that is invalid or that cannot be escaped, or with an escaped lone surrogate
+		enum struct invalid_sequence
+		{
+			//write U+FFFD instead
+			replace,
+			//leave it out
+			skip,
+			//stop and report where it is
+			stop
+		};
+
+		struct escape_options final
+		{
+			//escape every code point from U+0080 with \u, using surrogate pairs from U+10000
+			bool ascii_only = false;
+			invalid_sequence invalid = invalid_sequence::replace;
+		};
+
+		namespace detail
+		{
+			template<typename output_iterator>
+			auto put_u_escape(output_iterator out, std::uint32_t const unit)
+			-> output_iterator
+			{
+				static constexpr char hex[] = "0123456789abcdef";
+				*out = '\\';
+				*++out = 'u';
+				for(unsigned shift = 16; shift;)
+				{
+					shift -= 4;
+					*++out = hex[(unit >> shift) & 0xFu];
+				}
+				return ++out;
+			}
+			template<typename output_iterator>
+			auto put_short_escape(output_iterator out, char const c)
+			-> output_iterator
+			{
+				*out = '\\';
+				*++out = c;
+				return ++out;
+			}
+
+			//writes the code point as JSON string content, returns false without writing anything if it cannot be:
+			//JSON text is Unicode, so neither surrogates nor values above U+10FFFF can be written, escaped or not
+			template<typename output_iterator>
+			auto escape_code_point(std::uintmax_t const cp, bool const ascii_only, output_iterator &out)
+			-> bool
+			{
+				if(cp > 0x10FFFFu || (cp >= 0xD800u && cp <= 0xDFFFu))
+				{
+					return false;
+				}
+				switch(cp)
+				{
+					case '"': out = put_short_escape(out, '"'); return true;
+					case '\\': out = put_short_escape(out, '\\'); return true;
+					case '\b': out = put_short_escape(out, 'b'); return true;
+					case '\f': out = put_short_escape(out, 'f'); return true;
+					case '\n': out = put_short_escape(out, 'n'); return true;
+					case '\r': out = put_short_escape(out, 'r'); return true;
+					case '\t': out = put_short_escape(out, 't'); return true;
+				}
+				if(cp < 0x20u)
+				{
+					out = put_u_escape(out, static_cast<std::uint32_t>(cp));
+				}
+				else if(cp < 0x80u || !ascii_only)
+				{
+					out = encode_code_point<char>(cp, out);
+				}
+				else if(cp <= 0xFFFFu)
+				{
+					out = put_u_escape(out, static_cast<std::uint32_t>(cp));
+				}
+				else
+				{
+					std::uint32_t const v = static_cast<std::uint32_t>(cp) - 0x10000u;
+					out = put_u_escape(out, 0xD800u + (v >> 10));
+					out = put_u_escape(out, 0xDC00u + (v & 0x3FFu));
+				}
+				return true;
+			}
+
+			//escapes the sequence at it and moves past it, returns false if it has to stop there
+			template<typename code_unit_iterator, typename output_iterator>
+			auto escape_sequence(code_unit_iterator &it, code_unit_iterator const last, output_iterator &out, escape_options const &options)
+			-> bool
+			{
+				std::uintmax_t cp {};
+				auto const r = utf::read_code_point(it, last, cp);
+				if(r.second && escape_code_point(cp, options.ascii_only, out))
+				{
+					it = r.first;
+					return true;
+				}
+				switch(options.invalid)
+				{
+					case invalid_sequence::stop: return false;
+					case invalid_sequence::skip: break;
+					case invalid_sequence::replace: escape_code_point(0xFFFDu, options.ascii_only, out); break;
+				}
+				//an invalid sequence is skipped one code unit at a time, an unescapable one as a whole
+				if(r.second)
+				{
+					it = r.first;
+				}
+				else
+				{
+					++it;
+				}
+				return true;
+			}
+
+			//code units which need more than copying: controls, quotes, backslashes, and the start of anything that is not ASCII
+			inline auto json_specials() noexcept
+			-> simd::byte_set const &
+			{
+				static simd::byte_set const set = []
+				{
+					simd::byte_set s {};
+					for(unsigned b = 0; b < 0x20u; ++b)
+					{
+						s.insert(static_cast<unsigned char>(b));
+					}
+					for(unsigned b = 0x80u; b < 0x100u; ++b)
+					{
+						s.insert(static_cast<unsigned char>(b));
+					}
+					s.insert('"');
+					s.insert('\\');
+					return s;
+				}();
+				return set;
+			}
+
+			template<typename code_unit_iterator, typename output_iterator>
+			auto escape_json(code_unit_iterator const first, code_unit_iterator const last, output_iterator out, escape_options const &options, std::true_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				if(first == last)
+				{
+					return {first, out};
+				}
+				char const *it = reinterpret_cast<char const *>(to_bytes(first));
+				char const *const end = it + (last - first);
+				auto const &k = byte_kernels();
+				auto const &specials = json_specials();
+				while(it != end)
+				{
+					//clean runs are copied in bulk
+					char const *const run = it + k.find_in_set(reinterpret_cast<unsigned char const *>(it), static_cast<std::size_t>(end - it), specials);
+					out = std::copy(it, run, out);
+					it = run;
+					if(it == end || !escape_sequence(it, end, out, options))
+					{
+						break;
+					}
+				}
+				return {first + (it - reinterpret_cast<char const *>(to_bytes(first))), out};
+			}
+			template<typename code_unit_iterator, typename output_iterator>
+			auto escape_json(code_unit_iterator it, code_unit_iterator const last, output_iterator out, escape_options const &options, std::false_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				while(it != last)
+				{
+					if(!escape_sequence(it, last, out, options))
+					{
+						break;
+					}
+				}
+				return {it, out};
+			}
+
+			//the value of a hexadecimal digit, or 16 if c is not one
+			template<typename code_unit_t>
+			constexpr auto digit_value(code_unit_t const c) noexcept
+			-> std::uint32_t
+			{
+				return (c >= '0' && c <= '9')? static_cast<std::uint32_t>(c - '0')
+				     : (c >= 'a' && c <= 'f')? static_cast<std::uint32_t>(c - 'a' + 10)
+				     : (c >= 'A' && c <= 'F')? static_cast<std::uint32_t>(c - 'A' + 10)
+				     : 16;
+			}
+
+			template<typename code_unit_iterator>
+			auto read_hex(code_unit_iterator &it, code_unit_iterator const last, std::size_t digits, std::uint32_t &value)
+			-> bool
+			{
+				value = 0;
+				for(; digits; --digits, ++it)
+				{
+					if(it == last)
+					{
+						return false;
+					}
+					std::uint32_t const digit = digit_value(*it);
+					if(digit == 16)
+					{
+						return false;
+					}
+					value = (value << 4) | digit;
+				}
+				return true;
+			}
+
+			//reads up to max_digits more digits of the given base onto value, returns how many there were
+			template<typename code_unit_iterator>
+			auto read_digits(code_unit_iterator &it, code_unit_iterator const last, std::uint32_t const base, std::size_t const max_digits, std::uint32_t &value)
+			-> std::size_t
+			{
+				std::size_t n = 0;
+				for(; n < max_digits && it != last; ++n, ++it)
+				{
+					std::uint32_t const digit = digit_value(*it);
+					if(digit >= base)
+					{
+						break;
+					}
+					value = value*base + digit;
+				}
+				return n;
+			}
+
+			//decodes the escape sequence starting with the backslash at it and moves past it, returns false if it has to stop there
+			template<typename code_unit_iterator, typename output_iterator>
+			auto unescape_sequence(code_unit_iterator &it, code_unit_iterator const last, output_iterator &out, invalid_sequence const invalid)
+			-> bool
+			{
+				using code_unit_t = typename std::iterator_traits<code_unit_iterator>::value_type;
+				code_unit_iterator next = it;
+				if(++next == last)
+				{
+					return false;
+				}
+				auto const c = *next++;
+				std::uint32_t cp = 0;
+				switch(c)
+				{
+					case '"': case '\\': case '/': cp = static_cast<std::uint32_t>(c); break;
+					case 'b': cp = '\b'; break;
+					case 'f': cp = '\f'; break;
+					case 'n': cp = '\n'; break;
+					case 'r': cp = '\r'; break;
+					case 't': cp = '\t'; break;
+					case 'u': case 'U':
+					{
+						if(!read_hex(next, last, (c == 'u')? 4 : 8, cp))
+						{
+							return false;
+						}
+						break;
+					}
+					//the rest are C escapes, where \x and octal give the code point up to U+FF rather than a code unit
+					case 'a': cp = '\a'; break;
+					case 'v': cp = '\v'; break;
+					case '\'': case '?': cp = static_cast<std::uint32_t>(c); break;
+					case 'x':
+					{
+						if(!read_digits(next, last, 16, 2, cp))
+						{
+							return false;
+						}
+						break;
+					}
+					case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+					{
+						cp = static_cast<std::uint32_t>(c - '0');
+						read_digits(next, last, 8, 2, cp);
+						break;
+					}
+					default: return false;
+				}
+				if(cp >= 0xD800u && cp <= 0xDBFFu)
+				{
+					//a high surrogate only counts if a low one is escaped right after it
+					code_unit_iterator low = next;
+					std::uint32_t second = 0;
+					if(low != last && *low == '\\' && ++low != last && *low == 'u' && read_hex(++low, last, 4, second) && second >= 0xDC00u && second <= 0xDFFFu)
+					{
+						cp = 0x10000u + ((cp - 0xD800u) << 10) + (second - 0xDC00u);
+						next = low;
+					}
+				}
+				if(cp >= 0xD800u && cp <= 0xDFFFu)
+				{
+					switch(invalid)
+					{
+						case invalid_sequence::stop: return false;
+						case invalid_sequence::skip: it = next; return true;
+						case invalid_sequence::replace: cp = 0xFFFDu; break;
+					}
+				}
+				out = encode_code_point<code_unit_t>(cp, out);
+				it = next;
+				return true;
+			}
+
+			inline auto json_delimiters() noexcept
+			-> simd::byte_set const &
+			{
+				static simd::byte_set const set = []
+				{
+					simd::byte_set s {};
+					s.insert('"');
+					s.insert('\\');
+					return s;
+				}();
+				return set;
+			}
+
+			template<typename code_unit_iterator, typename output_iterator>
+			auto unescape_json(code_unit_iterator const first, code_unit_iterator const last, output_iterator out, invalid_sequence const invalid, std::true_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				using code_unit_t = typename std::iterator_traits<code_unit_iterator>::value_type;
+				if(first == last)
+				{
+					return {first, out};
+				}
+				code_unit_t const *const base = &*first;
+				code_unit_t const *it = base;
+				code_unit_t const *const end = base + (last - first);
+				auto const &k = byte_kernels();
+				auto const &delimiters = json_delimiters();
+				while(it != end)
+				{
+					//unescaped runs are copied in bulk
+					code_unit_t const *const run = it + k.find_in_set(reinterpret_cast<unsigned char const *>(it), static_cast<std::size_t>(end - it), delimiters);
+					out = std::copy(it, run, out);
+					it = run;
+					if(it == end || *it == '"' || !unescape_sequence(it, end, out, invalid))
+					{
+						break;
+					}
+				}
+				return {first + (it - base), out};
+			}
+			template<typename code_unit_iterator, typename output_iterator>
+			auto unescape_json(code_unit_iterator it, code_unit_iterator const last, output_iterator out, invalid_sequence const invalid, std::false_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				while(it != last && !(*it == '"'))
+				{
+					if(*it == '\\')
+					{
+						if(!unescape_sequence(it, last, out, invalid))
+						{
+							break;
+						}
+						continue;
+					}
+					*out = *it;
+					++out;
+					++it;
+				}
+				return {it, out};
+			}
+		}
+
+		//writes the code points as the contents of a JSON string, without the surrounding quotes, as 8-bit code units
+		//stops early only for invalid_sequence::stop, in which case the result's in is the sequence it stopped at
+		template<typename code_unit_iterator, typename output_iterator>
+		auto escape_json(code_unit_iterator const first, code_unit_iterator const last, output_iterator out, escape_options const &options = {})
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			return detail::escape_json(first, last, out, options, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+
+		//decodes the contents of a JSON string, writing escaped code points as encode_code_point would and copying other code units as they are
+		//stops at an unescaped quote or a malformed escape sequence, which is where the result's in refers to
+		template<typename code_unit_iterator, typename output_iterator>
+		auto unescape_json(code_unit_iterator const first, code_unit_iterator const last, output_iterator out, invalid_sequence const invalid = invalid_sequence::replace)
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			return detail::unescape_json(first, last, out, invalid, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+	}
+}
+
+#endif
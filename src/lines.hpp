@@ -0,0 +1,177 @@
+#ifndef LB_utf_lines_HeaderPlusPlus
+#define LB_utf_lines_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//the only code unit which ends a line
+			inline auto newlines() noexcept
+			-> simd::byte_set const &
+			{
+				static simd::byte_set const set = []
+				{
+					simd::byte_set s {};
+					s.insert('\n');
+					return s;
+				}();
+				return set;
+			}
+		}
+
+		//a zero-based line number and code point column within that line
+		struct line_position final
+		{
+			std::size_t line;
+			std::size_t column;
+		};
+
+		//maps code unit offsets in a text to lines and code point columns and back, in logarithmic time
+		//lines end after each '\n'; the text is not copied, so it must outlive the index
+		template<typename code_unit_t>
+		class basic_line_index final
+		{
+			using byte_input = detail::uses_byte_kernels<code_unit_t const *>;
+
+			code_unit_t const *text = nullptr;
+			std::size_t size = 0;
+			//the offset of the first code unit of each line
+			std::vector<std::size_t> starts;
+			//the number of code points starting before each checkpoint, which are checkpoint_interval code units apart
+			std::vector<std::size_t> checkpoints;
+
+			auto count_leads(std::size_t const first, std::size_t const last, std::true_type) const noexcept
+			-> std::size_t
+			{
+				return detail::byte_kernels().count_leads(detail::to_bytes(text + first), last - first);
+			}
+			auto count_leads(std::size_t first, std::size_t const last, std::false_type) const noexcept
+			-> std::size_t
+			{
+				std::size_t leads = 0;
+				for(; first < last; ++first)
+				{
+					leads += !detail::is_continuation(text[first]);
+				}
+				return leads;
+			}
+
+			void find_newlines(std::size_t i, std::size_t const last, std::true_type)
+			{
+				unsigned char const *const p = detail::to_bytes(text);
+				auto const &k = detail::byte_kernels();
+				while((i += k.find_in_set(p + i, last - i, detail::newlines())) < last)
+				{
+					starts.push_back(++i);
+				}
+			}
+			void find_newlines(std::size_t i, std::size_t const last, std::false_type)
+			{
+				for(; i < last; ++i)
+				{
+					if(text[i] == code_unit_t('\n'))
+					{
+						starts.push_back(i + 1);
+					}
+				}
+			}
+
+			//the number of code points starting before offset
+			auto code_points_before(std::size_t const offset) const noexcept
+			-> std::size_t
+			{
+				std::size_t const checkpoint = offset/checkpoint_interval;
+				return checkpoints[checkpoint] + count_leads(checkpoint*checkpoint_interval, offset, byte_input{});
+			}
+
+		public:
+			static constexpr std::size_t checkpoint_interval = 512;
+
+			basic_line_index() = default;
+			//builds the line and checkpoint tables in a single pass over the text
+			basic_line_index(code_unit_t const *const first, code_unit_t const *const last)
+			: text(first)
+			, size(static_cast<std::size_t>(last - first))
+			, starts{0}
+			{
+				checkpoints.reserve(size/checkpoint_interval + 1);
+				std::size_t leads = 0;
+				for(std::size_t block = 0; block <= size; block += checkpoint_interval)
+				{
+					checkpoints.push_back(leads);
+					std::size_t const end = std::min(block + checkpoint_interval, size);
+					find_newlines(block, end, byte_input{});
+					leads += count_leads(block, end, byte_input{});
+				}
+			}
+
+			//the number of lines, which is one more than the number of newlines
+			auto lines() const noexcept
+			-> std::size_t
+			{
+				return starts.size();
+			}
+
+			//the offset of the first code unit of the line, or the size of the text if there is no such line
+			auto line_start(std::size_t const line) const noexcept
+			-> std::size_t
+			{
+				return line < starts.size()? starts[line] : size;
+			}
+			//the offset of the newline ending the line, or the size of the text for the last line
+			auto line_end(std::size_t const line) const noexcept
+			-> std::size_t
+			{
+				return line + 1 < starts.size()? starts[line + 1] - 1 : size;
+			}
+
+			//the line containing the code unit at offset, and the number of code points on that line which start before it
+			//offsets past the end are treated as the end
+			auto position(std::size_t offset) const noexcept
+			-> line_position
+			{
+				offset = std::min(offset, size);
+				std::size_t const line = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin()) - 1;
+				return {line, code_points_before(offset) - code_points_before(starts[line])};
+			}
+
+			//the offset of the code point at the column of the line, or of the end of the line if it is not that long
+			auto offset(line_position const pos) const noexcept
+			-> std::size_t
+			{
+				std::size_t const start = line_start(pos.line)
+				,                 end = line_end(pos.line)
+				,                 target = code_points_before(start) + pos.column;
+				if(pos.line >= starts.size() || target >= code_points_before(end))
+				{
+					return end;
+				}
+				//the last checkpoint at or before the target, then a scan of at most one interval
+				std::size_t const checkpoint = static_cast<std::size_t>(std::upper_bound(checkpoints.begin(), checkpoints.end(), target) - checkpoints.begin()) - 1;
+				std::size_t leads = checkpoints[checkpoint];
+				for(std::size_t i = checkpoint*checkpoint_interval;; ++i)
+				{
+					if(!detail::is_continuation(text[i]) && leads++ == target)
+					{
+						return i;
+					}
+				}
+			}
+		};
+
+		using line_index = basic_line_index<char>;
+	}
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef LB_utf_parallel_HeaderPlusPlus
+#define LB_utf_parallel_HeaderPlusPlus
+
+#include "utf.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//fewer code points than this per thread are not worth starting a thread for
+			constexpr std::size_t min_parallel_chunk = std::size_t{1} << 16;
+
+			//joins every thread it holds when it goes away, so a thread that fails to start doesn't leave the others running
+			struct joining_threads final
+			{
+				std::vector<std::thread> threads;
+
+				~joining_threads()
+				{
+					for(auto &t : threads)
+					{
+						t.join();
+					}
+				}
+			};
+
+			//runs f(0) to f(n-1), all but the last on their own threads
+			//if a thread can't be started the exception propagates once the threads already started have finished
+			template<typename function_t>
+			void run_chunks(std::size_t const n, function_t const &f)
+			{
+				joining_threads started;
+				started.threads.reserve(n - 1);
+				for(std::size_t i = 0; i + 1 < n; ++i)
+				{
+					started.threads.emplace_back(f, i);
+				}
+				f(n - 1);
+			}
+		}
+
+		//encodes code points into a single string using several threads, with the same result as encoding them one by one
+		//each thread sums the lengths of its chunk, the sums give every chunk its offset, and then each thread encodes its chunk in place
+		template<typename code_unit_t, typename code_point_iterator>
+		auto encode_parallel(code_point_iterator const first, code_point_iterator const last, std::size_t threads = std::thread::hardware_concurrency())
+		-> std::basic_string<code_unit_t>
+		{
+			std::size_t const n = static_cast<std::size_t>(std::distance(first, last));
+			threads = std::max<std::size_t>(1, std::min(threads, n/detail::min_parallel_chunk));
+			auto const chunk_first = [&](std::size_t const chunk)
+			{
+				return first + static_cast<std::ptrdiff_t>(n/threads*chunk + std::min(chunk, n%threads));
+			};
+
+			std::vector<std::size_t> offsets (threads + 1);
+			detail::run_chunks(threads, [&](std::size_t const chunk)
+			{
+				std::size_t size = 0;
+				for(auto it = chunk_first(chunk), end = chunk_first(chunk + 1); it != end; ++it)
+				{
+					size += min_code_units<code_unit_t>(*it);
+				}
+				offsets[chunk + 1] = size;
+			});
+			for(std::size_t chunk = 0; chunk < threads; ++chunk)
+			{
+				offsets[chunk + 1] += offsets[chunk];
+			}
+
+			std::basic_string<code_unit_t> str (offsets.back(), code_unit_t{});
+			if(str.empty())
+			{
+				return str;
+			}
+			code_unit_t *const data = &str[0];
+			detail::run_chunks(threads, [&](std::size_t const chunk)
+			{
+				code_unit_t *out = data + offsets[chunk];
+				for(auto it = chunk_first(chunk), end = chunk_first(chunk + 1); it != end; ++it)
+				{
+					out = encode_code_point<code_unit_t>(*it, out);
+				}
+			});
+			return str;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,621 @@
+#ifndef LB_utf_simd_HeaderPlusPlus
+#define LB_utf_simd_HeaderPlusPlus
+
+#include "utf.hpp"
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+			//a set of 8-bit code units, laid out so vector kernels can test membership with two nibble lookups
+			struct byte_set final
+			{
+				//for each low nibble, bit (b >> 4) is set for members below 0x80
+				unsigned char ascii[16];
+				//for each low nibble, bit ((b >> 4) & 0b111) is set for members from 0x80
+				unsigned char high[16];
+
+				constexpr void insert(unsigned char const b) noexcept
+				{
+					(b < 0x80u? ascii : high)[b & 0xFu] |= static_cast<unsigned char>(1u << ((b >> 4) & 0b111u));
+				}
+				constexpr auto contains(unsigned char const b) const noexcept
+				-> bool
+				{
+					return (((b < 0x80u? ascii : high)[b & 0xFu] >> ((b >> 4) & 0b111u)) & 1u) != 0;
+				}
+			};
+
+			//how far a conversion kernel got through its input, and how much it wrote
+			struct conversion final
+			{
+				std::size_t read;
+				std::size_t written;
+			};
+
+			//table of bulk kernels operating on contiguous 8-bit code units
+			struct kernels final
+			{
+				char const *name;
+				//number of leading code units with the most significant bit clear
+				std::size_t (*ascii_prefix)(unsigned char const *p, std::size_t n);
+				//number of code units that are not continuations (0b10 header)
+				std::size_t (*count_leads)(unsigned char const *p, std::size_t n);
+				//first i such that p[i] == a and p[i+offset] == b with i+offset < n, or n
+				std::size_t (*find_pair)(unsigned char const *p, std::size_t n, unsigned char a, unsigned char b, std::size_t offset);
+				//first i such that p[i] is in the set, or n
+				std::size_t (*find_in_set)(unsigned char const *p, std::size_t n, byte_set const &set);
+				//copies the leading code units below 0x80 to 32-bit code units, returns how many
+				std::size_t (*widen_ascii)(unsigned char const *p, std::size_t n, std::uint32_t *out);
+				//copies the leading 32-bit code units below 0x80 to 8-bit code units, returns how many
+				std::size_t (*narrow_ascii)(std::uint32_t const *p, std::size_t n, unsigned char *out);
+				//copies the leading code units below 0x80 to out, returns how many
+				std::size_t (*copy_ascii)(unsigned char const *p, std::size_t n, unsigned char *out);
+				//number of leading code units below 0x80 before the first zero, the terminated version of ascii_prefix
+				//vector kernels read whole aligned blocks, which may go past the zero but never into another page
+				std::size_t (*ascii_prefix_terminated)(unsigned char const *p);
+				//number of code units before the first zero that are not continuations, the terminated version of count_leads
+				std::size_t (*count_leads_terminated)(unsigned char const *p);
+				//number of leading 16-, 32- or 64-bit code units with the most significant bit clear, the wider versions of ascii_prefix
+				std::size_t (*single_prefix16)(std::uint16_t const *p, std::size_t n);
+				std::size_t (*single_prefix32)(std::uint32_t const *p, std::size_t n);
+				std::size_t (*single_prefix64)(std::uint64_t const *p, std::size_t n);
+				//number of 16-, 32- or 64-bit code units that are not continuations, the wider versions of count_leads
+				std::size_t (*count_leads16)(std::uint16_t const *p, std::size_t n);
+				std::size_t (*count_leads32)(std::uint32_t const *p, std::size_t n);
+				std::size_t (*count_leads64)(std::uint64_t const *p, std::size_t n);
+				//number of code units with the most significant bit set, which is how many more UTF-8 code units the same Latin-1 text takes
+				std::size_t (*count_high)(unsigned char const *p, std::size_t n);
+				//encodes n Latin-1 characters as UTF-8, returns how many code units were written, out needs room for n + count_high(p, n)
+				std::size_t (*latin1_to_utf8)(unsigned char const *p, std::size_t n, unsigned char *out);
+				//decodes the leading ASCII and two code unit sequences for U+80 to U+FF to Latin-1,
+				//stopping at anything else, such as a longer or invalid sequence, for the caller to look at
+				conversion (*utf8_to_latin1)(unsigned char const *p, std::size_t n, unsigned char *out);
+			};
+
+			//the following are defined by the compiled utf_simd library
+
+			//the kernels selected for this machine, chosen once on first use
+			auto active() noexcept
+			-> kernels const &;
+
+			//looks up kernels by name ("scalar", "sse2", "avx2", "avx512")
+			//returns nullptr if they were not compiled in or the CPU does not support them
+			auto find_kernels(char const *name) noexcept
+			-> kernels const *;
+
+			//makes the bulk operations use active() from then on
+			void install() noexcept;
+
+			//the kernels the bulk operations use, or nullptr for the scalar ones until install() is called
+			//the headers read this the same way whether or not utf_simd is linked in, so every translation unit agrees
+			inline auto installed() noexcept
+			-> std::atomic<kernels const *> &
+			{
+				static std::atomic<kernels const *> k {nullptr};
+				return k;
+			}
+
+#ifdef LB_UTF_SIMD
+			namespace
+			{
+				//each translation unit which links utf_simd installs its kernels during static initialization,
+				//which also makes sure the linker keeps them when utf_simd is a static library
+				struct installer final
+				{
+					installer() noexcept
+					{
+						install();
+					}
+				} const install_on_startup;
+			}
+#endif
+		}
+
+		namespace scalar
+		{
+			inline auto ascii_prefix(unsigned char const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				static constexpr std::uint64_t high_bits = 0x8080808080808080ull;
+				std::size_t i = 0;
+				for(; i + 8 <= n; i += 8)
+				{
+					std::uint64_t word;
+					std::memcpy(&word, p + i, 8);
+					if(word & high_bits)
+					{
+						break;
+					}
+				}
+				for(; i < n; ++i)
+				{
+					if(p[i] & 0x80u)
+					{
+						break;
+					}
+				}
+				return i;
+			}
+
+			inline auto count_leads(unsigned char const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				std::size_t leads = 0;
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					leads += ((p[i] & 0xC0u) != 0x80u);
+				}
+				return leads;
+			}
+
+			inline auto find_pair(unsigned char const *p, std::size_t n, unsigned char const a, unsigned char const b, std::size_t const offset) noexcept
+			-> std::size_t
+			{
+				if(offset >= n)
+				{
+					return n;
+				}
+				for(std::size_t i = 0; i < n - offset; ++i)
+				{
+					if(p[i] == a && p[i + offset] == b)
+					{
+						return i;
+					}
+				}
+				return n;
+			}
+
+			inline auto find_in_set(unsigned char const *p, std::size_t n, simd::byte_set const &set) noexcept
+			-> std::size_t
+			{
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					if(set.contains(p[i]))
+					{
+						return i;
+					}
+				}
+				return n;
+			}
+
+			inline auto widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *out) noexcept
+			-> std::size_t
+			{
+				std::size_t i = 0;
+				for(; i < n && !(p[i] & 0x80u); ++i)
+				{
+					out[i] = p[i];
+				}
+				return i;
+			}
+
+			inline auto narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out) noexcept
+			-> std::size_t
+			{
+				std::size_t i = 0;
+				for(; i < n && p[i] < 0x80u; ++i)
+				{
+					out[i] = static_cast<unsigned char>(p[i]);
+				}
+				return i;
+			}
+
+			inline auto copy_ascii(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+			-> std::size_t
+			{
+				std::size_t const ascii = ascii_prefix(p, n);
+				if(ascii)
+				{
+					std::memcpy(out, p, ascii);
+				}
+				return ascii;
+			}
+
+			inline auto ascii_prefix_terminated(unsigned char const *p) noexcept
+			-> std::size_t
+			{
+				std::size_t i = 0;
+				for(; p[i] && !(p[i] & 0x80u); ++i)
+				{
+				}
+				return i;
+			}
+
+			inline auto count_leads_terminated(unsigned char const *p) noexcept
+			-> std::size_t
+			{
+				std::size_t leads = 0;
+				for(; *p; ++p)
+				{
+					leads += ((*p & 0xC0u) != 0x80u);
+				}
+				return leads;
+			}
+
+			template<typename code_unit_t>
+			inline auto single_prefix(code_unit_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				constexpr code_unit_t top = static_cast<code_unit_t>(code_unit_t{1} << (sizeof(code_unit_t)*CHAR_BIT - 1));
+				std::size_t i = 0;
+				for(; i < n && !(p[i] & top); ++i)
+				{
+				}
+				return i;
+			}
+
+			template<typename code_unit_t>
+			inline auto count_leads_wide(code_unit_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				constexpr std::size_t shift = sizeof(code_unit_t)*CHAR_BIT - 2;
+				std::size_t leads = 0;
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					leads += ((p[i] >> shift) != 0b10u);
+				}
+				return leads;
+			}
+
+			inline auto count_high(unsigned char const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				std::size_t high = 0;
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					high += (p[i] >> 7);
+				}
+				return high;
+			}
+
+			inline auto latin1_to_utf8(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+			-> std::size_t
+			{
+				std::size_t o = 0;
+				for(std::size_t i = 0; i < n; ++i)
+				{
+					if(p[i] < 0x80u)
+					{
+						out[o++] = p[i];
+					}
+					else
+					{
+						out[o++] = static_cast<unsigned char>(0xC0u | (p[i] >> 6));
+						out[o++] = static_cast<unsigned char>(0x80u | (p[i] & 0x3Fu));
+					}
+				}
+				return o;
+			}
+
+			inline auto utf8_to_latin1(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+			-> simd::conversion
+			{
+				std::size_t i = 0
+				,           o = 0;
+				while(i < n)
+				{
+					if(p[i] < 0x80u)
+					{
+						out[o++] = p[i++];
+					}
+					else if((p[i] & 0xFEu) == 0xC2u && i + 1 < n && (p[i + 1] & 0xC0u) == 0x80u)
+					{
+						out[o++] = static_cast<unsigned char>(((p[i] & 0b11u) << 6) | (p[i + 1] & 0x3Fu));
+						i += 2;
+					}
+					else
+					{
+						break;
+					}
+				}
+				return {i, o};
+			}
+
+			inline auto table() noexcept
+			-> simd::kernels const &
+			{
+				static constexpr simd::kernels k {"scalar", &ascii_prefix, &count_leads, &find_pair, &find_in_set, &widen_ascii, &narrow_ascii, &copy_ascii, &ascii_prefix_terminated, &count_leads_terminated,
+					&single_prefix<std::uint16_t>, &single_prefix<std::uint32_t>, &single_prefix<std::uint64_t>,
+					&count_leads_wide<std::uint16_t>, &count_leads_wide<std::uint32_t>, &count_leads_wide<std::uint64_t>,
+					&count_high, &latin1_to_utf8, &utf8_to_latin1};
+				return k;
+			}
+		}
+
+		namespace detail
+		{
+			//contiguous iterators over 8-bit code units can use the bulk kernels
+			template<typename code_unit_iterator>
+			using uses_byte_kernels = std::integral_constant<bool,
+				is_contiguous<code_unit_iterator>::value
+			&&	std::is_integral<typename std::iterator_traits<code_unit_iterator>::value_type>::value
+			&&	sizeof(typename std::iterator_traits<code_unit_iterator>::value_type) == 1>;
+
+			//contiguous iterators over 8-, 16-, 32- or 64-bit code units can be validated and counted by the bulk kernels
+			template<typename code_unit_iterator, std::size_t size = sizeof(typename std::iterator_traits<code_unit_iterator>::value_type)>
+			using uses_unit_kernels = std::integral_constant<bool,
+				is_contiguous<code_unit_iterator>::value
+			&&	std::is_integral<typename std::iterator_traits<code_unit_iterator>::value_type>::value
+			&&	(size == 1 || size == 2 || size == 4 || size == 8)>;
+
+			//the fixed width type the kernels take for code units of the given size
+			template<std::size_t size>
+			using kernel_unit_t = std::conditional_t<size == 1, unsigned char,
+				std::conditional_t<size == 2, std::uint16_t,
+				std::conditional_t<size == 4, std::uint32_t, std::uint64_t>>>;
+
+			//NUL-terminated pointers to 8-bit code units can use the terminated kernels
+			template<typename code_unit_iterator, typename sentinel_t>
+			using uses_terminated_kernels = std::integral_constant<bool,
+				std::is_pointer<code_unit_iterator>::value
+			&&	std::is_same<sentinel_t, null_sentinel>::value
+			&&	uses_byte_kernels<code_unit_iterator>::value>;
+
+			template<typename code_unit_iterator>
+			auto to_bytes(code_unit_iterator it) noexcept
+			-> unsigned char const *
+			{
+				return reinterpret_cast<unsigned char const *>(&*it);
+			}
+
+			inline auto byte_kernels() noexcept
+			-> simd::kernels const &
+			{
+				simd::kernels const *const k = simd::installed().load(std::memory_order_acquire);
+				return k? *k : scalar::table();
+			}
+
+			template<typename code_unit_iterator>
+			auto to_units(code_unit_iterator it) noexcept
+			-> kernel_unit_t<sizeof(typename std::iterator_traits<code_unit_iterator>::value_type)> const *
+			{
+				return reinterpret_cast<kernel_unit_t<sizeof(typename std::iterator_traits<code_unit_iterator>::value_type)> const *>(&*it);
+			}
+
+			//the kernels for each code unit width, chosen by overloading on the pointer type
+			inline auto single_prefix(unsigned char const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().ascii_prefix(p, n);
+			}
+			inline auto single_prefix(std::uint16_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().single_prefix16(p, n);
+			}
+			inline auto single_prefix(std::uint32_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().single_prefix32(p, n);
+			}
+			inline auto single_prefix(std::uint64_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().single_prefix64(p, n);
+			}
+			inline auto count_leads(unsigned char const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().count_leads(p, n);
+			}
+			inline auto count_leads(std::uint16_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().count_leads16(p, n);
+			}
+			inline auto count_leads(std::uint32_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().count_leads32(p, n);
+			}
+			inline auto count_leads(std::uint64_t const *p, std::size_t n) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().count_leads64(p, n);
+			}
+
+			//the number of ASCII code units at it, if the kernels can find them
+			template<typename code_unit_iterator>
+			auto ascii_run(code_unit_iterator const it, code_unit_iterator const last, std::true_type) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().ascii_prefix(to_bytes(it), static_cast<std::size_t>(last - it));
+			}
+			template<typename code_unit_iterator>
+			constexpr auto ascii_run(code_unit_iterator const, code_unit_iterator const, std::false_type) noexcept
+			-> std::size_t
+			{
+				return 0;
+			}
+
+			template<typename code_unit_iterator>
+			auto count_code_points(code_unit_iterator it, code_unit_iterator const last, std::true_type) noexcept
+			-> std::size_t
+			{
+				if(it == last)
+				{
+					return 0;
+				}
+				return count_leads(to_units(it), static_cast<std::size_t>(last - it));
+			}
+			template<typename code_unit_iterator>
+			auto count_code_points(code_unit_iterator const it, null_sentinel, std::true_type) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().count_leads_terminated(to_bytes(it));
+			}
+			template<typename code_unit_iterator, typename sentinel_t>
+			auto count_code_points(code_unit_iterator it, sentinel_t const last, std::false_type)
+			-> std::size_t
+			{
+				using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
+				static constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
+				static constexpr code_unit_t mask = static_cast<code_unit_t>(code_unit_t{0b11} << NUM_BITS-2);
+				static constexpr code_unit_t continuation = static_cast<code_unit_t>(code_unit_t{0b1} << NUM_BITS-1);
+				std::size_t leads = 0;
+				for(; it != last; ++it)
+				{
+					leads += ((static_cast<code_unit_t>(*it) & mask) != continuation);
+				}
+				return leads;
+			}
+
+			template<typename code_unit_iterator, typename instrumentation_t>
+			auto validate(code_unit_iterator it, code_unit_iterator const last, instrumentation_t &instrument, std::true_type)
+			-> code_unit_iterator
+			{
+				while(it != last)
+				{
+					//runs of code points which are a single code unit, ASCII for 8-bit code units
+					it += static_cast<std::ptrdiff_t>(single_prefix(to_units(it), static_cast<std::size_t>(last - it)));
+					if(it == last)
+					{
+						break;
+					}
+					instrument.on_fallback();
+					std::size_t const n = utf::num_code_units(it, last, true, instrument);
+					if(!n)
+					{
+						break;
+					}
+					it += static_cast<std::ptrdiff_t>(n);
+				}
+				return it;
+			}
+			template<typename code_unit_iterator, typename instrumentation_t>
+			auto validate(code_unit_iterator it, null_sentinel const last, instrumentation_t &instrument, std::true_type)
+			-> code_unit_iterator
+			{
+				auto const &k = byte_kernels();
+				for(;;)
+				{
+					it += static_cast<std::ptrdiff_t>(k.ascii_prefix_terminated(to_bytes(it)));
+					if(!*it)
+					{
+						break;
+					}
+					instrument.on_fallback();
+					std::size_t const n = utf::num_code_units(it, last, true, instrument);
+					if(!n)
+					{
+						break;
+					}
+					it += static_cast<std::ptrdiff_t>(n);
+				}
+				return it;
+			}
+			template<typename code_unit_iterator, typename sentinel_t, typename instrumentation_t>
+			auto validate(code_unit_iterator it, sentinel_t const last, instrumentation_t &instrument, std::false_type)
+			-> code_unit_iterator
+			{
+				while(it != last)
+				{
+					std::size_t const n = utf::num_code_units(it, last, true, instrument);
+					if(!n)
+					{
+						break;
+					}
+					std::advance(it, n);
+				}
+				return it;
+			}
+		}
+
+		template<typename code_unit_iterator>
+		auto count_code_points(code_unit_iterator first, code_unit_iterator const last)
+		-> std::size_t
+		{
+			return detail::count_code_points(first, last, detail::uses_unit_kernels<code_unit_iterator>{});
+		}
+
+		template<typename code_unit_iterator, typename instrumentation_t>
+		auto validate(code_unit_iterator first, code_unit_iterator const last, instrumentation_t &&instrument)
+		-> code_unit_iterator
+		{
+			return detail::validate(first, last, instrument, detail::uses_unit_kernels<code_unit_iterator>{});
+		}
+		template<typename code_unit_iterator>
+		auto validate(code_unit_iterator first, code_unit_iterator const last)
+		-> code_unit_iterator
+		{
+			return validate(first, last, no_instrumentation{});
+		}
+
+		//validates [first, last) after [edit_first, edit_last) was inserted or replaced in a buffer that was valid before, or after a deletion at edit_first == edit_last
+		//only the sequences from the one before the edit to the first sequence boundary after it are validated, since every other sequence is unchanged
+		//returns the same as validate(first, last) would, requires bidirectional iterators
+		//a sequence cut off by the edit is reported to instrumentation as truncated where validate would see error_kind::not_continuation
+		//the scans for those boundaries stop after the longest sequence that decodes into std::uintmax_t, and the whole buffer is validated if they find none
+		template<typename code_unit_iterator, typename instrumentation_t>
+		auto revalidate(code_unit_iterator const first, code_unit_iterator const last, code_unit_iterator const edit_first, code_unit_iterator const edit_last, instrumentation_t &&instrument)
+		-> code_unit_iterator
+		{
+			//no sequence that decodes into std::uintmax_t has this many continuations, so longer runs are validated from the start instead
+			constexpr std::size_t max_units = detail::max_code_units_for<unsigned_code_unit_t<code_unit_iterator>, std::uintmax_t>();
+			//the sequence before the edit may have lost its end, so start where it starts
+			code_unit_iterator start = edit_first;
+			for(std::size_t back = 0; start != first && detail::is_continuation(*--start);)
+			{
+				if(++back == max_units)
+				{
+					return validate(first, last, instrument);
+				}
+			}
+			//every code unit after the edit that is not a continuation was, and still is, the start of a valid sequence
+			code_unit_iterator end = edit_last;
+			for(std::size_t ahead = 0; end != last && detail::is_continuation(*end); ++end)
+			{
+				if(++ahead == max_units)
+				{
+					return validate(first, last, instrument);
+				}
+			}
+			code_unit_iterator const it = validate(start, end, instrument);
+			return it == end? last : it;
+		}
+		template<typename code_unit_iterator>
+		auto revalidate(code_unit_iterator const first, code_unit_iterator const last, code_unit_iterator const edit_first, code_unit_iterator const edit_last)
+		-> code_unit_iterator
+		{
+			return revalidate(first, last, edit_first, edit_last, no_instrumentation{});
+		}
+
+		//stop at a sentinel of a different type than the iterator, such as null_sentinel, without finding the end first
+		//NUL-terminated pointers to 8-bit code units are scanned with the terminated kernels
+		template<typename code_unit_iterator, typename sentinel_t>
+		auto count_code_points(code_unit_iterator first, sentinel_t const last)
+		-> std::size_t
+		{
+			return detail::count_code_points(first, last, detail::uses_terminated_kernels<code_unit_iterator, sentinel_t>{});
+		}
+
+		template<typename code_unit_iterator, typename sentinel_t, typename instrumentation_t>
+		auto validate(code_unit_iterator first, sentinel_t const last, instrumentation_t &&instrument)
+		-> code_unit_iterator
+		{
+			return detail::validate(first, last, instrument, detail::uses_terminated_kernels<code_unit_iterator, sentinel_t>{});
+		}
+		template<typename code_unit_iterator, typename sentinel_t>
+		auto validate(code_unit_iterator first, sentinel_t const last)
+		-> code_unit_iterator
+		{
+			return validate(first, last, no_instrumentation{});
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,383 @@
+#include "simd.hpp"
+#include "simd/bits.hpp"
+
+#include <cstring>
+#include <immintrin.h>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+			namespace
+			{
+				auto ascii_prefix(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						if(unsigned const mask = static_cast<unsigned>(_mm256_movemask_epi8(v)))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return i + tail_ascii_prefix(p + i, n - i);
+				}
+
+				auto count_leads(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					//continuations are 0x80-0xBF, which as signed bytes are all less than -64
+					__m256i const threshold = _mm256_set1_epi8(-65);
+					std::size_t leads = 0
+					,           i = 0;
+					while(i + 32 <= n)
+					{
+						//per-byte counters overflow after 255 iterations
+						__m256i acc = _mm256_setzero_si256();
+						for(std::size_t j = 0; j < 255 && i + 32 <= n; ++j, i += 32)
+						{
+							__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+							acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(v, threshold));
+						}
+						__m256i const sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+						leads += static_cast<std::size_t>(_mm256_extract_epi64(sums, 0))
+						      +  static_cast<std::size_t>(_mm256_extract_epi64(sums, 1))
+						      +  static_cast<std::size_t>(_mm256_extract_epi64(sums, 2))
+						      +  static_cast<std::size_t>(_mm256_extract_epi64(sums, 3));
+					}
+					return leads + tail_count_leads(p + i, n - i);
+				}
+
+				auto find_pair(unsigned char const *p, std::size_t n, unsigned char const a, unsigned char const b, std::size_t const offset)
+				-> std::size_t
+				{
+					__m256i const va = _mm256_set1_epi8(static_cast<char>(a));
+					__m256i const vb = _mm256_set1_epi8(static_cast<char>(b));
+					std::size_t i = 0;
+					for(; offset < n && i + offset + 32 <= n; i += 32)
+					{
+						__m256i const first = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i)), va);
+						__m256i const second = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i + offset)), vb);
+						if(unsigned const mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(first, second))))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return tail_find_pair(p, n, i, a, b, offset);
+				}
+
+				auto find_in_set(unsigned char const *p, std::size_t n, byte_set const &set)
+				-> std::size_t
+				{
+					//byte shuffles ignore the index when its most significant bit is set,
+					//so each table only applies to its own half of the code unit values
+					__m256i const ascii = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(set.ascii)));
+					__m256i const high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(set.high)));
+					__m256i const bits = _mm256_setr_epi8(
+						1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+						1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+					__m256i const flip = _mm256_set1_epi8(-128);
+					__m256i const nibble = _mm256_set1_epi8(0x0F);
+					std::size_t i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						__m256i const rows = _mm256_or_si256(_mm256_shuffle_epi8(ascii, v), _mm256_shuffle_epi8(high, _mm256_xor_si256(v, flip)));
+						__m256i const column = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+						__m256i const miss = _mm256_cmpeq_epi8(_mm256_and_si256(rows, column), _mm256_setzero_si256());
+						if(unsigned const mask = ~static_cast<unsigned>(_mm256_movemask_epi8(miss)))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return tail_find_in_set(p, n, i, set);
+				}
+
+				auto widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *out)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						if(_mm256_movemask_epi8(v))
+						{
+							break;
+						}
+						for(std::size_t j = 0; j < 32; j += 8)
+						{
+							__m128i const eight = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p + i + j));
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + j), _mm256_cvtepu8_epi32(eight));
+						}
+					}
+					return i + tail_widen_ascii(p + i, n - i, out + i);
+				}
+
+				auto narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					__m256i const high = _mm256_set1_epi32(-0x80);
+					//the packs work within 128-bit lanes, leaving groups of 4 code units in this order
+					__m256i const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+					std::size_t i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						__m256i const b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i + 8));
+						__m256i const c = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i + 16));
+						__m256i const d = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i + 24));
+						if(!_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)), high))
+						{
+							break;
+						}
+						__m256i const packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+						_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permutevar8x32_epi32(packed, order));
+					}
+					return i + tail_narrow_ascii(p + i, n - i, out + i);
+				}
+
+				auto copy_ascii(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						if(_mm256_movemask_epi8(v))
+						{
+							break;
+						}
+						_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+					}
+					return i + tail_copy_ascii(p + i, n - i, out + i);
+				}
+
+				//an aligned block for scan_terminated, which may lie partly outside the string
+				LB_UTF_NO_SANITIZE_ADDRESS inline auto load_block(unsigned char const *const block) noexcept
+				-> __m256i
+				{
+					return _mm256_load_si256(reinterpret_cast<__m256i const *>(block));
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto ascii_prefix_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					__m256i const zero = _mm256_setzero_si256();
+					return scan_terminated<32>(p, [&](unsigned char const *const block)
+					{
+						__m256i const v = load_block(block);
+						//zeroes become 0xFF, so both stops have the most significant bit set
+						return std::make_pair(std::uint64_t{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(v, _mm256_cmpeq_epi8(v, zero))))}, std::uint64_t{0});
+					}).length;
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto count_leads_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					__m256i const zero = _mm256_setzero_si256();
+					__m256i const threshold = _mm256_set1_epi8(-65);
+					return scan_terminated<32>(p, [&](unsigned char const *const block)
+					{
+						__m256i const v = load_block(block);
+						return std::make_pair(std::uint64_t{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)))}, std::uint64_t{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, threshold)))});
+					}).counted;
+				}
+
+				template<typename code_unit_t>
+				auto single_prefix(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					constexpr std::size_t lanes = 32/sizeof(code_unit_t);
+					constexpr unsigned high = static_cast<unsigned>(high_byte_bits<sizeof(code_unit_t)>() & 0xFFFFFFFFu);
+					std::size_t i = 0;
+					for(; i + lanes <= n; i += lanes)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						if(unsigned const mask = static_cast<unsigned>(_mm256_movemask_epi8(v)) & high)
+						{
+							return i + ctz(mask)/sizeof(code_unit_t);
+						}
+					}
+					return i + tail_single_prefix(p + i, n - i);
+				}
+
+				//all ones in each lane holding a code unit that is not a continuation:
+				//as signed values, continuations are exactly those less than the smallest lead, 0b11 followed by zeroes
+				inline auto lead_lanes(__m256i const v, std::integral_constant<std::size_t, 2>)
+				-> __m256i
+				{
+					return _mm256_cmpgt_epi16(v, _mm256_set1_epi16(-0x4001));
+				}
+				inline auto lead_lanes(__m256i const v, std::integral_constant<std::size_t, 4>)
+				-> __m256i
+				{
+					return _mm256_cmpgt_epi32(v, _mm256_set1_epi32(-0x40000001));
+				}
+				inline auto lead_lanes(__m256i const v, std::integral_constant<std::size_t, 8>)
+				-> __m256i
+				{
+					return _mm256_cmpgt_epi64(v, _mm256_set1_epi64x(-0x4000000000000001ll));
+				}
+
+				//the sum of the counters, which are 16-bit for 16-bit code units, 32-bit for 32-bit ones, and 64-bit for 64-bit ones
+				inline auto sum_lanes(__m256i const acc, std::integral_constant<std::size_t, 8>)
+				-> std::size_t
+				{
+					return static_cast<std::size_t>(_mm256_extract_epi64(acc, 0))
+					     + static_cast<std::size_t>(_mm256_extract_epi64(acc, 1))
+					     + static_cast<std::size_t>(_mm256_extract_epi64(acc, 2))
+					     + static_cast<std::size_t>(_mm256_extract_epi64(acc, 3));
+				}
+				inline auto sum_lanes(__m256i acc, std::integral_constant<std::size_t, 4>)
+				-> std::size_t
+				{
+					acc = _mm256_add_epi64(_mm256_and_si256(acc, _mm256_set1_epi64x(0xFFFFFFFFll)), _mm256_srli_epi64(acc, 32));
+					return sum_lanes(acc, std::integral_constant<std::size_t, 8>{});
+				}
+				inline auto sum_lanes(__m256i acc, std::integral_constant<std::size_t, 2>)
+				-> std::size_t
+				{
+					acc = _mm256_madd_epi16(acc, _mm256_set1_epi16(1));
+					return sum_lanes(acc, std::integral_constant<std::size_t, 4>{});
+				}
+
+				template<typename code_unit_t>
+				auto count_leads_wide(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					using size = std::integral_constant<std::size_t, sizeof(code_unit_t)>;
+					constexpr std::size_t lanes = 32/sizeof(code_unit_t);
+					std::size_t leads = 0
+					,           i = 0;
+					while(i + lanes <= n)
+					{
+						//16-bit counters would overflow as signed values after 32767 iterations
+						__m256i acc = _mm256_setzero_si256();
+						for(std::size_t j = 0; j < 32767 && i + lanes <= n; ++j, i += lanes)
+						{
+							__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+							__m256i const leading = lead_lanes(v, size{});
+							acc = (sizeof(code_unit_t) == 2)? _mm256_sub_epi16(acc, leading) : (sizeof(code_unit_t) == 4)? _mm256_sub_epi32(acc, leading) : _mm256_sub_epi64(acc, leading);
+						}
+						leads += sum_lanes(acc, size{});
+					}
+					return leads + tail_count_leads_wide(p + i, n - i);
+				}
+
+				auto count_high(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					std::size_t high = 0
+					,           i = 0;
+					for(; i + 32 <= n; i += 32)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						high += popcount(static_cast<std::uint32_t>(_mm256_movemask_epi8(v)));
+					}
+					return high + tail_count_high(p + i, n - i);
+				}
+
+				auto latin1_to_utf8(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					//characters from 0xC0 are all greater than -65 as signed bytes, and take 0xC3 as their lead rather than 0xC2
+					__m256i const threshold = _mm256_set1_epi8(-65);
+					__m256i const lead = _mm256_set1_epi8(static_cast<char>(0xC2));
+					__m256i const payload = _mm256_set1_epi8(static_cast<char>(0xBF));
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 32 <= n)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						std::uint32_t const mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+						if(!mask)
+						{
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), v);
+							i += 32;
+							o += 32;
+							continue;
+						}
+						if(mask == 0xFFFFFFFFu)
+						{
+							//every character takes two code units, which are interleaved within each 128-bit lane and then put back in order
+							__m256i const leads = _mm256_sub_epi8(lead, _mm256_cmpgt_epi8(v, threshold));
+							__m256i const continuations = _mm256_and_si256(v, payload);
+							__m256i const lo = _mm256_unpacklo_epi8(leads, continuations);
+							__m256i const hi = _mm256_unpackhi_epi8(leads, continuations);
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), _mm256_permute2x128_si256(lo, hi, 0x20));
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+							i += 32;
+							o += 64;
+							continue;
+						}
+						//the whole vector is stored for the ASCII before the first high character,
+						//every remaining character takes at least one code unit so the rest is overwritten and within out
+						std::size_t const ascii = ctz(mask);
+						_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), v);
+						o += ascii + encode_latin1_high(p[i + ascii], out + o + ascii);
+						i += ascii + 1;
+					}
+					return o + tail_latin1_to_utf8(p + i, n - i, out + o);
+				}
+
+				auto utf8_to_latin1(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> conversion
+				{
+					//as 16-bit lanes a two code unit sequence for U+80 to U+FF has its lead in the low byte
+					__m256i const pair_bits = _mm256_set1_epi16(static_cast<short>(0xC0FE));
+					__m256i const pair = _mm256_set1_epi16(static_cast<short>(0x80C2));
+					__m256i const lead_bits = _mm256_set1_epi16(0xC0);
+					__m256i const payload = _mm256_set1_epi16(0x3F);
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 32 <= n)
+					{
+						__m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + i));
+						std::uint32_t const mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+						if(!mask)
+						{
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), v);
+							i += 32;
+							o += 32;
+							continue;
+						}
+						if(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(v, pair_bits), pair))) == 0xFFFFFFFFu)
+						{
+							//the lowest two bits of the lead become the top two of the character,
+							//and the packs work within each 128-bit lane so the halves are gathered into the low one
+							__m256i const chars = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(v, 6), lead_bits), _mm256_and_si256(_mm256_srli_epi16(v, 8), payload));
+							__m256i const packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(chars, chars), 0b1000);
+							_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), _mm256_castsi256_si128(packed));
+							i += 32;
+							o += 16;
+							continue;
+						}
+						//the output may be exactly as long as the characters, so only the ASCII is copied
+						std::size_t const ascii = ctz(mask);
+						std::memcpy(out + o, p + i, ascii);
+						i += ascii;
+						o += ascii;
+						if(!is_latin1_pair(p + i, n - i))
+						{
+							return {i, o};
+						}
+						out[o++] = decode_latin1_pair(p + i);
+						i += 2;
+					}
+					conversion const tail = tail_utf8_to_latin1(p + i, n - i, out + o);
+					return {i + tail.read, o + tail.written};
+				}
+			}
+
+			extern kernels const avx2_kernels {"avx2", &ascii_prefix, &count_leads, &find_pair, &find_in_set, &widen_ascii, &narrow_ascii, &copy_ascii, &ascii_prefix_terminated, &count_leads_terminated,
+				&single_prefix<std::uint16_t>, &single_prefix<std::uint32_t>, &single_prefix<std::uint64_t>,
+				&count_leads_wide<std::uint16_t>, &count_leads_wide<std::uint32_t>, &count_leads_wide<std::uint64_t>,
+				&count_high, &latin1_to_utf8, &utf8_to_latin1};
+		}
+	}
+}
@@ -0,0 +1,356 @@
+#include "simd.hpp"
+#include "simd/bits.hpp"
+
+#include <immintrin.h>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+			namespace
+			{
+				auto ascii_prefix(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 64 <= n; i += 64)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						if(std::uint64_t const mask = _mm512_movepi8_mask(v))
+						{
+							return i + ctz(mask);
+						}
+					}
+					if(i < n)
+					{
+						__mmask64 const live = ~std::uint64_t{0} >> (64 - (n - i));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						if(std::uint64_t const mask = _mm512_movepi8_mask(v))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return n;
+				}
+
+				auto count_leads(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					//continuations are 0x80-0xBF, which as signed bytes are all less than -64
+					__m512i const threshold = _mm512_set1_epi8(-65);
+					std::size_t leads = 0
+					,           i = 0;
+					for(; i + 64 <= n; i += 64)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						leads += popcount(_mm512_cmpgt_epi8_mask(v, threshold));
+					}
+					if(i < n)
+					{
+						__mmask64 const live = ~std::uint64_t{0} >> (64 - (n - i));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						leads += popcount(_mm512_mask_cmpgt_epi8_mask(live, v, threshold));
+					}
+					return leads;
+				}
+
+				auto find_pair(unsigned char const *p, std::size_t n, unsigned char const a, unsigned char const b, std::size_t const offset)
+				-> std::size_t
+				{
+					__m512i const va = _mm512_set1_epi8(static_cast<char>(a));
+					__m512i const vb = _mm512_set1_epi8(static_cast<char>(b));
+					std::size_t i = 0;
+					for(; offset < n && i + offset + 64 <= n; i += 64)
+					{
+						std::uint64_t const first = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i), va);
+						if(std::uint64_t const mask = first & _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i + offset), vb))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return tail_find_pair(p, n, i, a, b, offset);
+				}
+
+				auto find_in_set(unsigned char const *p, std::size_t n, byte_set const &set)
+				-> std::size_t
+				{
+					//byte shuffles ignore the index when its most significant bit is set,
+					//so each table only applies to its own half of the code unit values
+					__m512i const ascii = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(set.ascii)));
+					__m512i const high = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(set.high)));
+					__m512i const bits = _mm512_broadcast_i32x4(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+					__m512i const flip = _mm512_set1_epi8(-128);
+					__m512i const nibble = _mm512_set1_epi8(0x0F);
+					std::size_t i = 0;
+					while(i < n)
+					{
+						__mmask64 const live = (n - i >= 64)? ~__mmask64{0} : (~std::uint64_t{0} >> (64 - (n - i)));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						__m512i const rows = _mm512_or_si512(_mm512_shuffle_epi8(ascii, v), _mm512_shuffle_epi8(high, _mm512_xor_si512(v, flip)));
+						__m512i const column = _mm512_shuffle_epi8(bits, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble));
+						if(std::uint64_t const mask = _mm512_mask_test_epi8_mask(live, rows, column))
+						{
+							return i + ctz(mask);
+						}
+						i += 64;
+					}
+					return n;
+				}
+
+				auto widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *out)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 64 <= n; i += 64)
+					{
+						if(_mm512_movepi8_mask(_mm512_loadu_si512(p + i)))
+						{
+							break;
+						}
+						for(std::size_t j = 0; j < 64; j += 16)
+						{
+							__m128i const sixteen = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i + j));
+							_mm512_storeu_si512(out + i + j, _mm512_cvtepu8_epi32(sixteen));
+						}
+					}
+					return i + tail_widen_ascii(p + i, n - i, out + i);
+				}
+
+				auto narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					__m512i const high = _mm512_set1_epi32(-0x80);
+					std::size_t i = 0;
+					for(; i + 64 <= n; i += 64)
+					{
+						__m512i const a = _mm512_loadu_si512(p + i);
+						__m512i const b = _mm512_loadu_si512(p + i + 16);
+						__m512i const c = _mm512_loadu_si512(p + i + 32);
+						__m512i const d = _mm512_loadu_si512(p + i + 48);
+						if(_mm512_test_epi32_mask(_mm512_or_si512(_mm512_or_si512(a, b), _mm512_or_si512(c, d)), high))
+						{
+							break;
+						}
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm512_cvtepi32_epi8(a));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 16), _mm512_cvtepi32_epi8(b));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 32), _mm512_cvtepi32_epi8(c));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 48), _mm512_cvtepi32_epi8(d));
+					}
+					return i + tail_narrow_ascii(p + i, n - i, out + i);
+				}
+
+				auto copy_ascii(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					for(std::size_t i = 0; i < n; i += 64)
+					{
+						//the last block is loaded and stored masked, and so is the ASCII part of a block that is not all ASCII
+						__mmask64 const live = n - i >= 64? ~std::uint64_t{0} : ~std::uint64_t{0} >> (64 - (n - i));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						if(std::uint64_t const high = _mm512_movepi8_mask(v))
+						{
+							std::size_t const ascii = ctz(high);
+							_mm512_mask_storeu_epi8(out + i, (std::uint64_t{1} << ascii) - 1, v);
+							return i + ascii;
+						}
+						_mm512_mask_storeu_epi8(out + i, live, v);
+					}
+					return n;
+				}
+
+				//an aligned block for scan_terminated, which may lie partly outside the string
+				LB_UTF_NO_SANITIZE_ADDRESS inline auto load_block(unsigned char const *const block) noexcept
+				-> __m512i
+				{
+					return _mm512_load_si512(block);
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto ascii_prefix_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					return scan_terminated<64>(p, [](unsigned char const *const block)
+					{
+						__m512i const v = load_block(block);
+						return std::make_pair(std::uint64_t{_mm512_movepi8_mask(v) | _mm512_testn_epi8_mask(v, v)}, std::uint64_t{0});
+					}).length;
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto count_leads_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					__m512i const threshold = _mm512_set1_epi8(-65);
+					return scan_terminated<64>(p, [&](unsigned char const *const block)
+					{
+						__m512i const v = load_block(block);
+						return std::make_pair(std::uint64_t{_mm512_testn_epi8_mask(v, v)}, std::uint64_t{_mm512_cmpgt_epi8_mask(v, threshold)});
+					}).counted;
+				}
+
+				template<typename code_unit_t>
+				auto single_prefix(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					constexpr std::size_t lanes = 64/sizeof(code_unit_t);
+					constexpr std::uint64_t high = high_byte_bits<sizeof(code_unit_t)>();
+					std::size_t i = 0;
+					for(; i + lanes <= n; i += lanes)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						if(std::uint64_t const mask = _mm512_movepi8_mask(v) & high)
+						{
+							return i + ctz(mask)/sizeof(code_unit_t);
+						}
+					}
+					if(i < n)
+					{
+						__mmask64 const live = ~std::uint64_t{0} >> (64 - (n - i)*sizeof(code_unit_t));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						if(std::uint64_t const mask = _mm512_movepi8_mask(v) & high)
+						{
+							return i + ctz(mask)/sizeof(code_unit_t);
+						}
+					}
+					return n;
+				}
+
+				template<typename code_unit_t>
+				auto count_leads_wide(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					//the same test as count_leads, on the most significant byte of each code unit
+					constexpr std::size_t lanes = 64/sizeof(code_unit_t);
+					constexpr std::uint64_t high = high_byte_bits<sizeof(code_unit_t)>();
+					__m512i const threshold = _mm512_set1_epi8(-65);
+					std::size_t leads = 0
+					,           i = 0;
+					for(; i + lanes <= n; i += lanes)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						leads += popcount(_mm512_cmpgt_epi8_mask(v, threshold) & high);
+					}
+					if(i < n)
+					{
+						__mmask64 const live = ~std::uint64_t{0} >> (64 - (n - i)*sizeof(code_unit_t));
+						__m512i const v = _mm512_maskz_loadu_epi8(live, p + i);
+						leads += popcount(_mm512_mask_cmpgt_epi8_mask(live, v, threshold) & high);
+					}
+					return leads;
+				}
+
+				auto count_high(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					std::size_t high = 0
+					,           i = 0;
+					for(; i + 64 <= n; i += 64)
+					{
+						high += popcount(_mm512_movepi8_mask(_mm512_loadu_si512(p + i)));
+					}
+					if(i < n)
+					{
+						__mmask64 const live = ~std::uint64_t{0} >> (64 - (n - i));
+						high += popcount(_mm512_movepi8_mask(_mm512_maskz_loadu_epi8(live, p + i)));
+					}
+					return high;
+				}
+
+				auto latin1_to_utf8(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					//characters from 0xC0 are all greater than -65 as signed bytes, and take 0xC3 as their lead rather than 0xC2
+					__m512i const threshold = _mm512_set1_epi8(-65);
+					__m512i const lead2 = _mm512_set1_epi8(static_cast<char>(0xC2));
+					__m512i const lead3 = _mm512_set1_epi8(static_cast<char>(0xC3));
+					__m512i const payload = _mm512_set1_epi8(static_cast<char>(0xBF));
+					//the 64-bit halves of each 128-bit lane of the interleaved code units, in order
+					__m512i const first_half = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+					__m512i const second_half = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 64 <= n)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						std::uint64_t const mask = _mm512_movepi8_mask(v);
+						if(!mask)
+						{
+							_mm512_storeu_si512(out + o, v);
+							i += 64;
+							o += 64;
+							continue;
+						}
+						if(mask == ~std::uint64_t{0})
+						{
+							//every character takes two code units, which are interleaved within each 128-bit lane and then put back in order
+							__m512i const leads = _mm512_mask_blend_epi8(_mm512_cmpgt_epi8_mask(v, threshold), lead2, lead3);
+							__m512i const continuations = _mm512_and_si512(v, payload);
+							__m512i const lo = _mm512_unpacklo_epi8(leads, continuations);
+							__m512i const hi = _mm512_unpackhi_epi8(leads, continuations);
+							_mm512_storeu_si512(out + o, _mm512_permutex2var_epi64(lo, first_half, hi));
+							_mm512_storeu_si512(out + o + 64, _mm512_permutex2var_epi64(lo, second_half, hi));
+							i += 64;
+							o += 128;
+							continue;
+						}
+						std::size_t const ascii = ctz(mask);
+						_mm512_mask_storeu_epi8(out + o, (std::uint64_t{1} << ascii) - 1, v);
+						o += ascii + encode_latin1_high(p[i + ascii], out + o + ascii);
+						i += ascii + 1;
+					}
+					return o + tail_latin1_to_utf8(p + i, n - i, out + o);
+				}
+
+				auto utf8_to_latin1(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> conversion
+				{
+					//as 16-bit lanes a two code unit sequence for U+80 to U+FF has its lead in the low byte
+					__m512i const pair_bits = _mm512_set1_epi16(static_cast<short>(0xC0FE));
+					__m512i const pair = _mm512_set1_epi16(static_cast<short>(0x80C2));
+					__m512i const lead_bits = _mm512_set1_epi16(0xC0);
+					__m512i const payload = _mm512_set1_epi16(0x3F);
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 64 <= n)
+					{
+						__m512i const v = _mm512_loadu_si512(p + i);
+						std::uint64_t const mask = _mm512_movepi8_mask(v);
+						if(!mask)
+						{
+							_mm512_storeu_si512(out + o, v);
+							i += 64;
+							o += 64;
+							continue;
+						}
+						if(_mm512_cmpeq_epi16_mask(_mm512_and_si512(v, pair_bits), pair) == 0xFFFFFFFFu)
+						{
+							//the lowest two bits of the lead become the top two of the character
+							__m512i const chars = _mm512_or_si512(_mm512_and_si512(_mm512_slli_epi16(v, 6), lead_bits), _mm512_and_si512(_mm512_srli_epi16(v, 8), payload));
+							_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), _mm512_cvtepi16_epi8(chars));
+							i += 64;
+							o += 32;
+							continue;
+						}
+						std::size_t const ascii = ctz(mask);
+						_mm512_mask_storeu_epi8(out + o, (std::uint64_t{1} << ascii) - 1, v);
+						i += ascii;
+						o += ascii;
+						if(!is_latin1_pair(p + i, n - i))
+						{
+							return {i, o};
+						}
+						out[o++] = decode_latin1_pair(p + i);
+						i += 2;
+					}
+					conversion const tail = tail_utf8_to_latin1(p + i, n - i, out + o);
+					return {i + tail.read, o + tail.written};
+				}
+			}
+
+			extern kernels const avx512_kernels {"avx512", &ascii_prefix, &count_leads, &find_pair, &find_in_set, &widen_ascii, &narrow_ascii, &copy_ascii, &ascii_prefix_terminated, &count_leads_terminated,
+				&single_prefix<std::uint16_t>, &single_prefix<std::uint32_t>, &single_prefix<std::uint64_t>,
+				&count_leads_wide<std::uint16_t>, &count_leads_wide<std::uint32_t>, &count_leads_wide<std::uint64_t>,
+				&count_high, &latin1_to_utf8, &utf8_to_latin1};
+		}
+	}
+}
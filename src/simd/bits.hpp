@@ -0,0 +1,313 @@
+#ifndef LB_utf_simd_bits_HeaderPlusPlus
+#define LB_utf_simd_bits_HeaderPlusPlus
+
+//private helpers shared by the compiled kernels, not installed
+
+#include "simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+//the terminated kernels deliberately read whole aligned blocks before and past the string, which AddressSanitizer would report
+#if defined(_MSC_VER)
+	#define LB_UTF_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#elif defined(__GNUC__)
+	#define LB_UTF_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+	#define LB_UTF_NO_SANITIZE_ADDRESS
+#endif
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+			namespace
+			{
+				inline auto ctz(std::uint64_t v) noexcept
+				-> std::size_t
+				{
+#ifdef _MSC_VER
+					unsigned long i;
+					_BitScanForward64(&i, v);
+					return i;
+#else
+					return static_cast<std::size_t>(__builtin_ctzll(v));
+#endif
+				}
+
+				inline auto popcount(std::uint64_t v) noexcept
+				-> std::size_t
+				{
+#ifdef _MSC_VER
+					return static_cast<std::size_t>(__popcnt64(v));
+#else
+					return static_cast<std::size_t>(__builtin_popcountll(v));
+#endif
+				}
+
+				//tails are handled here rather than with the inline header functions,
+				//since those would be emitted with this translation unit's instruction set
+				inline auto tail_ascii_prefix(unsigned char const *p, std::size_t n) noexcept
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					while(i < n && !(p[i] & 0x80u))
+					{
+						++i;
+					}
+					return i;
+				}
+
+				inline auto tail_find_pair(unsigned char const *p, std::size_t n, std::size_t i, unsigned char const a, unsigned char const b, std::size_t const offset) noexcept
+				-> std::size_t
+				{
+					for(; i + offset < n; ++i)
+					{
+						if(p[i] == a && p[i + offset] == b)
+						{
+							return i;
+						}
+					}
+					return n;
+				}
+
+				//byte_set::contains would be emitted with this translation unit's instruction set too
+				inline auto in_set(byte_set const &set, unsigned char const b) noexcept
+				-> bool
+				{
+					return (((b < 0x80u? set.ascii : set.high)[b & 0xFu] >> ((b >> 4) & 0b111u)) & 1u) != 0;
+				}
+
+				inline auto tail_find_in_set(unsigned char const *p, std::size_t n, std::size_t i, byte_set const &set) noexcept
+				-> std::size_t
+				{
+					for(; i < n; ++i)
+					{
+						if(in_set(set, p[i]))
+						{
+							return i;
+						}
+					}
+					return n;
+				}
+
+				inline auto tail_widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *out) noexcept
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i < n && !(p[i] & 0x80u); ++i)
+					{
+						out[i] = p[i];
+					}
+					return i;
+				}
+
+				inline auto tail_narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out) noexcept
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i < n && p[i] < 0x80u; ++i)
+					{
+						out[i] = static_cast<unsigned char>(p[i]);
+					}
+					return i;
+				}
+
+				inline auto tail_copy_ascii(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i < n && !(p[i] & 0x80u); ++i)
+					{
+						out[i] = p[i];
+					}
+					return i;
+				}
+
+				inline auto tail_count_leads(unsigned char const *p, std::size_t n) noexcept
+				-> std::size_t
+				{
+					std::size_t leads = 0;
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						leads += ((p[i] & 0xC0u) != 0x80u);
+					}
+					return leads;
+				}
+
+				template<typename code_unit_t>
+				inline auto tail_single_prefix(code_unit_t const *p, std::size_t n) noexcept
+				-> std::size_t
+				{
+					constexpr code_unit_t top = static_cast<code_unit_t>(code_unit_t{1} << (sizeof(code_unit_t)*8 - 1));
+					std::size_t i = 0;
+					while(i < n && !(p[i] & top))
+					{
+						++i;
+					}
+					return i;
+				}
+
+				template<typename code_unit_t>
+				inline auto tail_count_leads_wide(code_unit_t const *p, std::size_t n) noexcept
+				-> std::size_t
+				{
+					std::size_t leads = 0;
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						leads += ((p[i] >> (sizeof(code_unit_t)*8 - 2)) != 0b10u);
+					}
+					return leads;
+				}
+
+				inline auto tail_count_high(unsigned char const *p, std::size_t n) noexcept
+				-> std::size_t
+				{
+					std::size_t high = 0;
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						high += (p[i] >> 7);
+					}
+					return high;
+				}
+
+				//the two code units of U+80 to U+FF, for a Latin-1 character with the most significant bit set
+				inline auto encode_latin1_high(unsigned char const b, unsigned char *out) noexcept
+				-> std::size_t
+				{
+					out[0] = static_cast<unsigned char>(0xC0u | (b >> 6));
+					out[1] = static_cast<unsigned char>(0x80u | (b & 0x3Fu));
+					return 2;
+				}
+
+				inline auto tail_latin1_to_utf8(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+				-> std::size_t
+				{
+					std::size_t o = 0;
+					for(std::size_t i = 0; i < n; ++i)
+					{
+						if(p[i] < 0x80u)
+						{
+							out[o++] = p[i];
+						}
+						else
+						{
+							o += encode_latin1_high(p[i], out + o);
+						}
+					}
+					return o;
+				}
+
+				//whether p[0] and p[1] are a two code unit sequence for U+80 to U+FF, given that p[0] is not ASCII
+				inline auto is_latin1_pair(unsigned char const *p, std::size_t n) noexcept
+				-> bool
+				{
+					return (p[0] & 0xFEu) == 0xC2u && n > 1 && (p[1] & 0xC0u) == 0x80u;
+				}
+
+				//the Latin-1 character for a two code unit sequence is_latin1_pair accepts
+				inline auto decode_latin1_pair(unsigned char const *p) noexcept
+				-> unsigned char
+				{
+					return static_cast<unsigned char>(((p[0] & 0b11u) << 6) | (p[1] & 0x3Fu));
+				}
+
+				inline auto tail_utf8_to_latin1(unsigned char const *p, std::size_t n, unsigned char *out) noexcept
+				-> conversion
+				{
+					std::size_t i = 0
+					,           o = 0;
+					while(i < n)
+					{
+						if(p[i] < 0x80u)
+						{
+							out[o++] = p[i++];
+						}
+						else if(is_latin1_pair(p + i, n - i))
+						{
+							out[o++] = decode_latin1_pair(p + i);
+							i += 2;
+						}
+						else
+						{
+							break;
+						}
+					}
+					return {i, o};
+				}
+
+				//a bit for each byte of a 64-byte vector which holds the most significant byte of a code unit of the given size,
+				//which on x86 is the last byte of each code unit
+				template<std::size_t size>
+				constexpr auto high_byte_bits() noexcept
+				-> std::uint64_t
+				{
+					std::uint64_t bits = 0;
+					for(std::size_t i = size - 1; i < 64; i += size)
+					{
+						bits |= std::uint64_t{1} << i;
+					}
+					return bits;
+				}
+				//the same bytes of a 64-bit lane set to 0xFF
+				template<std::size_t size>
+				constexpr auto high_byte_lanes() noexcept
+				-> std::uint64_t
+				{
+					std::uint64_t lanes = 0;
+					for(std::size_t i = size - 1; i < 8; i += size)
+					{
+						lanes |= std::uint64_t{0xFF} << (i*8);
+					}
+					return lanes;
+				}
+
+				//the position of the first stop bit at or after p, and how many counted bits come before it
+				struct terminated_scan final
+				{
+					std::size_t length
+					,           counted;
+				};
+
+				//scans whole aligned blocks of width code units, starting with the one that contains p
+				//an aligned block never straddles a page, so this cannot fault even though it reads past the stop and before p
+				//the over-read is deliberate and stays within the pages of the string, so it is hidden from AddressSanitizer
+				//block_masks(block) returns {stop bits, counted bits} with bit i for block[i], and must load the block with a function marked the same way
+				template<std::size_t width, typename block_masks_t>
+				LB_UTF_NO_SANITIZE_ADDRESS inline auto scan_terminated(unsigned char const *const p, block_masks_t const block_masks) noexcept
+				-> terminated_scan
+				{
+					std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(p);
+					std::size_t const skip = static_cast<std::size_t>(address % width);
+					std::uintptr_t block = address - skip;
+					auto masks = block_masks(reinterpret_cast<unsigned char const *>(block));
+					std::uint64_t stop = masks.first >> skip
+					,             counted = masks.second >> skip;
+					terminated_scan r {0, 0};
+					for(std::size_t length = width - skip; !stop; length = width)
+					{
+						r.length += length;
+						r.counted += popcount(counted);
+						block += width;
+						masks = block_masks(reinterpret_cast<unsigned char const *>(block));
+						stop = masks.first;
+						counted = masks.second;
+					}
+					std::size_t const i = ctz(stop);
+					r.length += i;
+					r.counted += popcount(counted & ((std::uint64_t{1} << i) - 1));
+					return r;
+				}
+			}
+		}
+	}
+}
+
+#endif
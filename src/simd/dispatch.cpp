@@ -0,0 +1,136 @@
+#include "simd.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+#ifdef LB_UTF_SIMD_X86
+			extern kernels const sse2_kernels;
+			extern kernels const avx2_kernels;
+			extern kernels const avx512_kernels;
+#endif
+
+			namespace
+			{
+#ifdef LB_UTF_SIMD_X86
+				enum struct isa
+				{
+					sse2,
+					avx2,
+					avx512
+				};
+
+				auto cpu_supports(isa const i) noexcept
+				-> bool
+				{
+#ifdef _MSC_VER
+					int regs[4];
+					__cpuid(regs, 0);
+					int const max_leaf = regs[0];
+					__cpuid(regs, 1);
+					bool const osxsave = (regs[2] & (1 << 27)) != 0;
+					if(i == isa::sse2)
+					{
+						return (regs[3] & (1 << 26)) != 0;
+					}
+					if(!osxsave || max_leaf < 7)
+					{
+						return false;
+					}
+					unsigned long long const xcr0 = _xgetbv(0);
+					__cpuidex(regs, 7, 0);
+					if(i == isa::avx2)
+					{
+						return (xcr0 & 0x6) == 0x6 && (regs[1] & (1 << 5)) != 0;
+					}
+					//avx512f and avx512bw, plus opmask and zmm state
+					return (xcr0 & 0xE6) == 0xE6 && (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+#else
+					__builtin_cpu_init();
+					switch(i)
+					{
+						case isa::sse2: return __builtin_cpu_supports("sse2");
+						case isa::avx2: return __builtin_cpu_supports("avx2");
+						case isa::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+					}
+					return false;
+#endif
+				}
+#endif
+
+				auto select() noexcept
+				-> kernels const &
+				{
+					//allow forcing a particular (supported) set of kernels for diagnostics
+					if(char const *const forced = std::getenv("LB_UTF_SIMD"))
+					{
+						if(kernels const *const k = find_kernels(forced))
+						{
+							return *k;
+						}
+					}
+#ifdef LB_UTF_SIMD_X86
+					if(cpu_supports(isa::avx512))
+					{
+						return avx512_kernels;
+					}
+					if(cpu_supports(isa::avx2))
+					{
+						return avx2_kernels;
+					}
+					if(cpu_supports(isa::sse2))
+					{
+						return sse2_kernels;
+					}
+#endif
+					return scalar::table();
+				}
+			}
+
+			auto active() noexcept
+			-> kernels const &
+			{
+				static kernels const &k = select();
+				return k;
+			}
+
+			void install() noexcept
+			{
+				installed().store(&active(), std::memory_order_release);
+			}
+
+			auto find_kernels(char const *name) noexcept
+			-> kernels const *
+			{
+				if(std::strcmp(name, "scalar") == 0)
+				{
+					return &scalar::table();
+				}
+#ifdef LB_UTF_SIMD_X86
+				if(std::strcmp(name, "sse2") == 0 && cpu_supports(isa::sse2))
+				{
+					return &sse2_kernels;
+				}
+				if(std::strcmp(name, "avx2") == 0 && cpu_supports(isa::avx2))
+				{
+					return &avx2_kernels;
+				}
+				if(std::strcmp(name, "avx512") == 0 && cpu_supports(isa::avx512))
+				{
+					return &avx512_kernels;
+				}
+#endif
+				return nullptr;
+			}
+		}
+	}
+}
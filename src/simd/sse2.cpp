@@ -0,0 +1,365 @@
+#include "simd.hpp"
+#include "simd/bits.hpp"
+
+#include <cstring>
+#include <emmintrin.h>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace simd
+		{
+			namespace
+			{
+				auto ascii_prefix(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 16 <= n; i += 16)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						if(unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(v)))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return i + tail_ascii_prefix(p + i, n - i);
+				}
+
+				auto count_leads(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					//continuations are 0x80-0xBF, which as signed bytes are all less than -64
+					__m128i const threshold = _mm_set1_epi8(-65);
+					std::size_t leads = 0
+					,           i = 0;
+					while(i + 16 <= n)
+					{
+						//per-byte counters overflow after 255 iterations
+						__m128i acc = _mm_setzero_si128();
+						for(std::size_t j = 0; j < 255 && i + 16 <= n; ++j, i += 16)
+						{
+							__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+							acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(v, threshold));
+						}
+						__m128i const sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+						leads += static_cast<std::size_t>(_mm_cvtsi128_si32(sums))
+						      +  static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+					}
+					return leads + tail_count_leads(p + i, n - i);
+				}
+
+				auto find_pair(unsigned char const *p, std::size_t n, unsigned char const a, unsigned char const b, std::size_t const offset)
+				-> std::size_t
+				{
+					__m128i const va = _mm_set1_epi8(static_cast<char>(a));
+					__m128i const vb = _mm_set1_epi8(static_cast<char>(b));
+					std::size_t i = 0;
+					for(; offset < n && i + offset + 16 <= n; i += 16)
+					{
+						__m128i const first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i)), va);
+						__m128i const second = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i + offset)), vb);
+						if(unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(first, second))))
+						{
+							return i + ctz(mask);
+						}
+					}
+					return tail_find_pair(p, n, i, a, b, offset);
+				}
+
+				auto find_in_set(unsigned char const *p, std::size_t n, byte_set const &set)
+				-> std::size_t
+				{
+					//SSE2 has no byte shuffle, so membership is tested one code unit at a time
+					return tail_find_in_set(p, n, 0, set);
+				}
+
+				auto widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *out)
+				-> std::size_t
+				{
+					__m128i const zero = _mm_setzero_si128();
+					std::size_t i = 0;
+					for(; i + 16 <= n; i += 16)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						if(_mm_movemask_epi8(v))
+						{
+							break;
+						}
+						__m128i const lo = _mm_unpacklo_epi8(v, zero);
+						__m128i const hi = _mm_unpackhi_epi8(v, zero);
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi16(lo, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+					}
+					return i + tail_widen_ascii(p + i, n - i, out + i);
+				}
+
+				auto narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					__m128i const high = _mm_set1_epi32(-0x80);
+					__m128i const zero = _mm_setzero_si128();
+					std::size_t i = 0;
+					for(; i + 16 <= n; i += 16)
+					{
+						__m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						__m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i + 4));
+						__m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i + 8));
+						__m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i + 12));
+						__m128i const any = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high);
+						if(_mm_movemask_epi8(_mm_cmpeq_epi32(any, zero)) != 0xFFFF)
+						{
+							break;
+						}
+						//every value fits in 7 bits, so the saturating packs just truncate
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+					}
+					return i + tail_narrow_ascii(p + i, n - i, out + i);
+				}
+
+				auto copy_ascii(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					std::size_t i = 0;
+					for(; i + 16 <= n; i += 16)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						if(_mm_movemask_epi8(v))
+						{
+							break;
+						}
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+					}
+					return i + tail_copy_ascii(p + i, n - i, out + i);
+				}
+
+				//an aligned block for scan_terminated, which may lie partly outside the string
+				LB_UTF_NO_SANITIZE_ADDRESS inline auto load_block(unsigned char const *const block) noexcept
+				-> __m128i
+				{
+					return _mm_load_si128(reinterpret_cast<__m128i const *>(block));
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto ascii_prefix_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					__m128i const zero = _mm_setzero_si128();
+					return scan_terminated<16>(p, [&](unsigned char const *const block)
+					{
+						__m128i const v = load_block(block);
+						//zeroes become 0xFF, so both stops have the most significant bit set
+						return std::make_pair(std::uint64_t{static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero))))}, std::uint64_t{0});
+					}).length;
+				}
+
+				LB_UTF_NO_SANITIZE_ADDRESS auto count_leads_terminated(unsigned char const *p)
+				-> std::size_t
+				{
+					__m128i const zero = _mm_setzero_si128();
+					__m128i const threshold = _mm_set1_epi8(-65);
+					return scan_terminated<16>(p, [&](unsigned char const *const block)
+					{
+						__m128i const v = load_block(block);
+						return std::make_pair(std::uint64_t{static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)))}, std::uint64_t{static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, threshold)))});
+					}).counted;
+				}
+
+				template<typename code_unit_t>
+				auto single_prefix(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					constexpr std::size_t lanes = 16/sizeof(code_unit_t);
+					constexpr unsigned high = static_cast<unsigned>(high_byte_bits<sizeof(code_unit_t)>() & 0xFFFFu);
+					std::size_t i = 0;
+					for(; i + lanes <= n; i += lanes)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						if(unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(v)) & high)
+						{
+							return i + ctz(mask)/sizeof(code_unit_t);
+						}
+					}
+					return i + tail_single_prefix(p + i, n - i);
+				}
+
+				//all ones in each lane holding a code unit that is not a continuation:
+				//as signed values, continuations are exactly those less than the smallest lead, 0b11 followed by zeroes
+				inline auto lead_lanes(__m128i const v, std::integral_constant<std::size_t, 2>)
+				-> __m128i
+				{
+					return _mm_cmpgt_epi16(v, _mm_set1_epi16(-0x4001));
+				}
+				inline auto lead_lanes(__m128i const v, std::integral_constant<std::size_t, 4>)
+				-> __m128i
+				{
+					return _mm_cmpgt_epi32(v, _mm_set1_epi32(-0x40000001));
+				}
+				inline auto lead_lanes(__m128i const v, std::integral_constant<std::size_t, 8>)
+				-> __m128i
+				{
+					//SSE2 has no 64-bit compare, so only the upper half of each code unit is kept
+					return _mm_and_si128(_mm_cmpgt_epi32(v, _mm_set1_epi32(-0x40000001)), _mm_set_epi32(-1, 0, -1, 0));
+				}
+
+				//the sum of the counters, which are 16-bit for 16-bit code units and 32-bit otherwise
+				inline auto sum_lanes(__m128i const acc, std::integral_constant<std::size_t, 4>)
+				-> std::size_t
+				{
+					__m128i const pairs = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+					return static_cast<std::size_t>(static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_add_epi32(pairs, _mm_srli_si128(pairs, 4)))));
+				}
+				inline auto sum_lanes(__m128i const acc, std::integral_constant<std::size_t, 8>)
+				-> std::size_t
+				{
+					return sum_lanes(acc, std::integral_constant<std::size_t, 4>{});
+				}
+				inline auto sum_lanes(__m128i acc, std::integral_constant<std::size_t, 2>)
+				-> std::size_t
+				{
+					acc = _mm_madd_epi16(acc, _mm_set1_epi16(1));
+					return sum_lanes(acc, std::integral_constant<std::size_t, 4>{});
+				}
+
+				template<typename code_unit_t>
+				auto count_leads_wide(code_unit_t const *p, std::size_t n)
+				-> std::size_t
+				{
+					using size = std::integral_constant<std::size_t, sizeof(code_unit_t)>;
+					constexpr std::size_t lanes = 16/sizeof(code_unit_t);
+					std::size_t leads = 0
+					,           i = 0;
+					while(i + lanes <= n)
+					{
+						//16-bit counters would overflow as signed values after 32767 iterations
+						__m128i acc = _mm_setzero_si128();
+						for(std::size_t j = 0; j < 32767 && i + lanes <= n; ++j, i += lanes)
+						{
+							__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+							acc = (sizeof(code_unit_t) == 2)? _mm_sub_epi16(acc, lead_lanes(v, size{})) : _mm_sub_epi32(acc, lead_lanes(v, size{}));
+						}
+						leads += sum_lanes(acc, size{});
+					}
+					return leads + tail_count_leads_wide(p + i, n - i);
+				}
+
+				auto count_high(unsigned char const *p, std::size_t n)
+				-> std::size_t
+				{
+					__m128i const zero = _mm_setzero_si128();
+					std::size_t high = 0
+					,           i = 0;
+					while(i + 16 <= n)
+					{
+						//per-byte counters overflow after 255 iterations
+						__m128i acc = _mm_setzero_si128();
+						for(std::size_t j = 0; j < 255 && i + 16 <= n; ++j, i += 16)
+						{
+							__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+							acc = _mm_sub_epi8(acc, _mm_cmplt_epi8(v, zero));
+						}
+						__m128i const sums = _mm_sad_epu8(acc, zero);
+						high += static_cast<std::size_t>(_mm_cvtsi128_si32(sums))
+						     +  static_cast<std::size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+					}
+					return high + tail_count_high(p + i, n - i);
+				}
+
+				auto latin1_to_utf8(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> std::size_t
+				{
+					//characters from 0xC0 are all greater than -65 as signed bytes, and take 0xC3 as their lead rather than 0xC2
+					__m128i const threshold = _mm_set1_epi8(-65);
+					__m128i const lead = _mm_set1_epi8(static_cast<char>(0xC2));
+					__m128i const payload = _mm_set1_epi8(static_cast<char>(0xBF));
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 16 <= n)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(v));
+						if(!mask)
+						{
+							_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), v);
+							i += 16;
+							o += 16;
+							continue;
+						}
+						if(mask == 0xFFFFu)
+						{
+							//every character takes two code units, which are interleaved
+							__m128i const leads = _mm_sub_epi8(lead, _mm_cmpgt_epi8(v, threshold));
+							__m128i const continuations = _mm_and_si128(v, payload);
+							_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), _mm_unpacklo_epi8(leads, continuations));
+							_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o + 16), _mm_unpackhi_epi8(leads, continuations));
+							i += 16;
+							o += 32;
+							continue;
+						}
+						//the whole vector is stored for the ASCII before the first high character,
+						//every remaining character takes at least one code unit so the rest is overwritten and within out
+						std::size_t const ascii = ctz(mask);
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), v);
+						o += ascii + encode_latin1_high(p[i + ascii], out + o + ascii);
+						i += ascii + 1;
+					}
+					return o + tail_latin1_to_utf8(p + i, n - i, out + o);
+				}
+
+				auto utf8_to_latin1(unsigned char const *p, std::size_t n, unsigned char *out)
+				-> conversion
+				{
+					//as 16-bit lanes a two code unit sequence for U+80 to U+FF has its lead in the low byte
+					__m128i const pair_bits = _mm_set1_epi16(static_cast<short>(0xC0FE));
+					__m128i const pair = _mm_set1_epi16(static_cast<short>(0x80C2));
+					__m128i const lead_bits = _mm_set1_epi16(0xC0);
+					__m128i const payload = _mm_set1_epi16(0x3F);
+					std::size_t i = 0
+					,           o = 0;
+					while(i + 16 <= n)
+					{
+						__m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+						unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(v));
+						if(!mask)
+						{
+							_mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), v);
+							i += 16;
+							o += 16;
+							continue;
+						}
+						if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, pair_bits), pair)) == 0xFFFF)
+						{
+							//the lowest two bits of the lead become the top two of the character
+							__m128i const chars = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 6), lead_bits), _mm_and_si128(_mm_srli_epi16(v, 8), payload));
+							_mm_storel_epi64(reinterpret_cast<__m128i *>(out + o), _mm_packus_epi16(chars, chars));
+							i += 16;
+							o += 8;
+							continue;
+						}
+						//the output may be exactly as long as the characters, so only the ASCII is copied
+						std::size_t const ascii = ctz(mask);
+						std::memcpy(out + o, p + i, ascii);
+						i += ascii;
+						o += ascii;
+						if(!is_latin1_pair(p + i, n - i))
+						{
+							return {i, o};
+						}
+						out[o++] = decode_latin1_pair(p + i);
+						i += 2;
+					}
+					conversion const tail = tail_utf8_to_latin1(p + i, n - i, out + o);
+					return {i + tail.read, o + tail.written};
+				}
+			}
+
+			extern kernels const sse2_kernels {"sse2", &ascii_prefix, &count_leads, &find_pair, &find_in_set, &widen_ascii, &narrow_ascii, &copy_ascii, &ascii_prefix_terminated, &count_leads_terminated,
+				&single_prefix<std::uint16_t>, &single_prefix<std::uint32_t>, &single_prefix<std::uint64_t>,
+				&count_leads_wide<std::uint16_t>, &count_leads_wide<std::uint32_t>, &count_leads_wide<std::uint64_t>,
+				&count_high, &latin1_to_utf8, &utf8_to_latin1};
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#ifndef LB_utf_sort_HeaderPlusPlus
+#define LB_utf_sort_HeaderPlusPlus
+
+#include "compare.hpp"
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//a string being sorted, by where its code units are and where it was in the input
+			template<typename code_unit_t>
+			struct sort_key final
+			{
+				code_unit_t const *units;
+				std::size_t size;
+				std::size_t index;
+			};
+
+			//whether every sequence is valid and as short as possible, in which case code unit order is code point order
+			template<typename code_unit_iterator>
+			auto is_canonical(code_unit_iterator it, code_unit_iterator const last)
+			-> bool
+			{
+				using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
+				bool ascii = true;
+				while(it != last)
+				{
+					if(ascii && uses_byte_kernels<code_unit_iterator>::value)
+					{
+						std::advance(it, ascii_run(it, last, uses_byte_kernels<code_unit_iterator>{}));
+						if(it == last)
+						{
+							break;
+						}
+					}
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second || r.second != min_code_units<code_unit_t>(cp))
+					{
+						return false;
+					}
+					it = r.first;
+					ascii = cp < 0x80u;
+				}
+				return true;
+			}
+
+			//the byte of a key at depth, counting the bytes of each code unit from the most significant,
+			//shifted up by one so that 0 means the key has ended and orders first
+			template<typename code_unit_t>
+			constexpr auto radix_digit(sort_key<code_unit_t> const &key, std::size_t const depth) noexcept
+			-> std::size_t
+			{
+				return (depth/sizeof(code_unit_t) < key.size)
+					? ((key.units[depth/sizeof(code_unit_t)] >> ((sizeof(code_unit_t) - 1 - depth%sizeof(code_unit_t))*CHAR_BIT)) & 0xFFu) + 1
+					: 0;
+			}
+
+			//whether a orders before b by code units, given that their first depth bytes are equal
+			template<typename code_unit_t>
+			auto radix_less(sort_key<code_unit_t> const &a, sort_key<code_unit_t> const &b, std::size_t const depth) noexcept
+			-> bool
+			{
+				std::size_t const skip = std::min(depth/sizeof(code_unit_t), std::min(a.size, b.size));
+				return std::lexicographical_compare(a.units + skip, a.units + a.size, b.units + skip, b.units + b.size);
+			}
+
+			//sorts keys by their code units a byte at a time from the most significant, which is code point order for canonical keys
+			template<typename code_unit_t>
+			void radix_sort(std::vector<sort_key<code_unit_t>> &keys)
+			{
+				//buckets this small are sorted by insertion instead of being split further
+				constexpr std::size_t small = 32;
+				struct pending final
+				{
+					std::size_t first;
+					std::size_t last;
+					std::size_t depth;
+				};
+				std::vector<sort_key<code_unit_t>> scratch (keys.size());
+				std::vector<pending> stack {pending{0, keys.size(), 0}};
+				while(!stack.empty())
+				{
+					pending const p = stack.back();
+					stack.pop_back();
+
+					if(p.last - p.first <= small)
+					{
+						for(std::size_t i = p.first + 1; i < p.last; ++i)
+						{
+							auto const key = keys[i];
+							std::size_t j = i;
+							for(; j > p.first && radix_less(key, keys[j - 1], p.depth); --j)
+							{
+								keys[j] = keys[j - 1];
+							}
+							keys[j] = key;
+						}
+						continue;
+					}
+
+					std::array<std::size_t, 257> starts {};
+					for(std::size_t i = p.first; i < p.last; ++i)
+					{
+						++starts[radix_digit(keys[i], p.depth)];
+					}
+					std::size_t offset = p.first;
+					for(auto &start : starts)
+					{
+						std::size_t const count = start;
+						start = offset;
+						offset += count;
+					}
+					auto next = starts;
+					for(std::size_t i = p.first; i < p.last; ++i)
+					{
+						scratch[next[radix_digit(keys[i], p.depth)]++] = keys[i];
+					}
+					std::copy(std::begin(scratch) + static_cast<std::ptrdiff_t>(p.first), std::begin(scratch) + static_cast<std::ptrdiff_t>(p.last), std::begin(keys) + static_cast<std::ptrdiff_t>(p.first));
+
+					//keys which ended are all equal, the rest continue with the next byte
+					for(std::size_t digit = 1; digit < starts.size(); ++digit)
+					{
+						if(next[digit] - starts[digit] > 1)
+						{
+							stack.push_back(pending{starts[digit], next[digit], p.depth + 1});
+						}
+					}
+				}
+			}
+		}
+
+		//sorts a random access range of strings, such as std::string or std::vector of code units, by code point order
+		//the strings of canonical code units, where every sequence is valid and minimal, are sorted with an MSD radix sort
+		//which never decodes them; the rest are sorted with compare and merged in, so the result always matches compare
+		//like std::sort, equal strings may not keep their relative order
+		template<typename string_iterator>
+		void sort_code_point_order(string_iterator const first, string_iterator const last)
+		{
+			using string_t = typename std::iterator_traits<string_iterator>::value_type;
+			using unit_iterator = decltype(std::cbegin(std::declval<string_t const &>()));
+			static_assert(detail::is_contiguous<unit_iterator>::value, "the code units of each string must be contiguous");
+			using code_unit_t = unsigned_code_unit_t<unit_iterator>;
+			using key_t = detail::sort_key<code_unit_t>;
+
+			std::vector<key_t> canonical;
+			std::vector<key_t> other;
+			std::size_t const n = static_cast<std::size_t>(last - first);
+			canonical.reserve(n);
+			for(std::size_t i = 0; i < n; ++i)
+			{
+				auto const &str = first[static_cast<std::ptrdiff_t>(i)];
+				auto const b = std::cbegin(str);
+				auto const e = std::cend(str);
+				key_t const key {(b == e)? nullptr : reinterpret_cast<code_unit_t const *>(&*b), static_cast<std::size_t>(e - b), i};
+				(detail::is_canonical(key.units, key.units + key.size)? canonical : other).push_back(key);
+			}
+
+			auto const less = [](key_t const &a, key_t const &b)
+			{
+				return compare_code_point_order(a.units, a.units + a.size, b.units, b.units + b.size) < 0;
+			};
+			detail::radix_sort(canonical);
+			std::stable_sort(std::begin(other), std::end(other), less);
+			std::vector<key_t> sorted (n);
+			std::merge(std::begin(canonical), std::end(canonical), std::begin(other), std::end(other), std::begin(sorted), less);
+
+			std::vector<string_t> moved;
+			moved.reserve(n);
+			for(auto const &key : sorted)
+			{
+				moved.push_back(std::move(first[static_cast<std::ptrdiff_t>(key.index)]));
+			}
+			std::move(std::begin(moved), std::end(moved), first);
+		}
+	}
+}
+
+#endif
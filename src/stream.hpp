@@ -0,0 +1,407 @@
+#ifndef LB_utf_stream_HeaderPlusPlus
+#define LB_utf_stream_HeaderPlusPlus
+
+#include "utf.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <streambuf>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace LB
+{
+	namespace utf
+	{
+		//reads raw bytes from a std::streambuf
+		struct streambuf_source final
+		{
+			std::streambuf *buf;
+
+			auto read(void *dst, std::size_t n)
+			-> std::size_t
+			{
+				constexpr std::size_t max = static_cast<std::size_t>(std::numeric_limits<std::streamsize>::max());
+				std::streamsize const got = buf->sgetn(static_cast<char *>(dst), static_cast<std::streamsize>(n < max? n : max));
+				return got > 0? static_cast<std::size_t>(got) : 0;
+			}
+		};
+
+		//reads raw bytes from a file descriptor, error holds errno if reading failed
+		struct fd_source final
+		{
+			int fd;
+			int error = 0;
+
+			auto read(void *dst, std::size_t n) noexcept
+			-> std::size_t
+			{
+				for(;;)
+				{
+#ifdef _WIN32
+					int const got = ::_read(fd, dst, static_cast<unsigned>(n < 0x7FFFFFFFu? n : 0x7FFFFFFFu));
+#else
+					auto const got = ::read(fd, dst, n);
+#endif
+					if(got >= 0)
+					{
+						return static_cast<std::size_t>(got);
+					}
+					if(errno != EINTR)
+					{
+						error = errno;
+						return 0;
+					}
+				}
+			}
+		};
+
+		//decodes code points pulled from a source in large blocks, using constant memory
+		//a source is anything with a member function std::size_t read(void *dst, std::size_t n) which returns 0 at the end
+		//bytes are reinterpreted as code units with native endianness; a trailing partial code unit is ignored
+		template<typename source_t, typename code_unit_t = char>
+		class reader final
+		{
+			source_t src;
+			std::vector<code_unit_t> buffer;
+			std::size_t pos = 0    //in code units
+			,           filled = 0; //in bytes
+			bool exhausted = false;
+			std::uintmax_t consumed = 0;
+
+			//notices when a sequence was only rejected because the buffer ended
+			struct truncation final
+			{
+				bool truncated = false;
+
+				constexpr void on_sequence(std::size_t) const noexcept
+				{
+				}
+				void on_error(error_kind const kind) noexcept
+				{
+					truncated = (kind == error_kind::truncated);
+				}
+				constexpr void on_header_overflow(std::size_t) const noexcept
+				{
+				}
+				constexpr void on_fallback() const noexcept
+				{
+				}
+			};
+
+			auto available() const noexcept
+			-> std::size_t
+			{
+				return filled/sizeof(code_unit_t) - pos;
+			}
+
+			//moves the unread code units to the front of the buffer and reads more after them
+			auto refill()
+			-> bool
+			{
+				if(exhausted)
+				{
+					return false;
+				}
+				unsigned char *const bytes = reinterpret_cast<unsigned char *>(buffer.data());
+				std::size_t const start = pos*sizeof(code_unit_t);
+				std::memmove(bytes, bytes + start, filled - start);
+				filled -= start;
+				pos = 0;
+				if(filled == buffer.size()*sizeof(code_unit_t))
+				{
+					//a single sequence is longer than the whole buffer
+					buffer.resize(buffer.size()*2);
+					return refill();
+				}
+				std::size_t const got = src.read(reinterpret_cast<unsigned char *>(buffer.data()) + filled, buffer.size()*sizeof(code_unit_t) - filled);
+				if(!got)
+				{
+					exhausted = true;
+					return false;
+				}
+				filled += got;
+				return true;
+			}
+
+		public:
+			static constexpr std::size_t default_block_size = std::size_t{1} << 16;
+
+			explicit reader(source_t source, std::size_t const block_size = default_block_size)
+			: src(std::move(source))
+			, buffer(block_size? block_size : 1)
+			{
+			}
+
+			//decodes the next code point and returns the number of code units it was made of
+			//returns 0 if the sequence was invalid, in which case one code unit was skipped, or if there was nothing left to read
+			template<typename code_point_t>
+			auto read(code_point_t &cp)
+			-> std::size_t
+			{
+				for(;;)
+				{
+					if(!available() && !refill())
+					{
+						return 0;
+					}
+					code_unit_t const *const first = buffer.data() + pos;
+					truncation t;
+					std::size_t const n = read_code_point(first, first + available(), cp, t).second;
+					if(n)
+					{
+						pos += n;
+						consumed += n;
+						return n;
+					}
+					if(t.truncated && refill())
+					{
+						continue;
+					}
+					++pos;
+					++consumed;
+					return 0;
+				}
+			}
+
+			//whether every code unit has been read, may read more from the source to find out
+			auto eof()
+			-> bool
+			{
+				return !available() && !refill();
+			}
+
+			//total number of code units read or skipped so far
+			auto code_units_read() const noexcept
+			-> std::uintmax_t
+			{
+				return consumed;
+			}
+
+			auto source() noexcept
+			-> source_t &
+			{
+				return src;
+			}
+		};
+
+		template<typename code_unit_t = char>
+		auto make_reader(std::streambuf &buf, std::size_t const block_size = reader<streambuf_source>::default_block_size)
+		-> reader<streambuf_source, code_unit_t>
+		{
+			return reader<streambuf_source, code_unit_t>{streambuf_source{&buf}, block_size};
+		}
+		template<typename code_unit_t = char>
+		auto make_reader(std::istream &in, std::size_t const block_size = reader<streambuf_source>::default_block_size)
+		-> reader<streambuf_source, code_unit_t>
+		{
+			return make_reader<code_unit_t>(*in.rdbuf(), block_size);
+		}
+		template<typename code_unit_t = char>
+		auto make_fd_reader(int const fd, std::size_t const block_size = reader<fd_source>::default_block_size)
+		-> reader<fd_source, code_unit_t>
+		{
+			return reader<fd_source, code_unit_t>{fd_source{fd}, block_size};
+		}
+
+		//writes raw bytes to a std::streambuf
+		struct streambuf_sink final
+		{
+			std::streambuf *buf;
+
+			auto write(void const *src, std::size_t n)
+			-> bool
+			{
+				constexpr std::size_t max = static_cast<std::size_t>(std::numeric_limits<std::streamsize>::max());
+				char const *p = static_cast<char const *>(src);
+				while(n)
+				{
+					std::size_t const chunk = n < max? n : max;
+					if(buf->sputn(p, static_cast<std::streamsize>(chunk)) != static_cast<std::streamsize>(chunk))
+					{
+						return false;
+					}
+					p += chunk;
+					n -= chunk;
+				}
+				return true;
+			}
+		};
+
+		//writes raw bytes to a file descriptor, error holds errno if writing failed
+		struct fd_sink final
+		{
+			int fd;
+			int error = 0;
+
+			auto write(void const *src, std::size_t n) noexcept
+			-> bool
+			{
+				char const *p = static_cast<char const *>(src);
+				while(n)
+				{
+#ifdef _WIN32
+					int const put = ::_write(fd, p, static_cast<unsigned>(n < 0x7FFFFFFFu? n : 0x7FFFFFFFu));
+#else
+					auto const put = ::write(fd, p, n);
+#endif
+					if(put < 0)
+					{
+						if(errno == EINTR)
+						{
+							continue;
+						}
+						error = errno;
+						return false;
+					}
+					p += put;
+					n -= static_cast<std::size_t>(put);
+				}
+				return true;
+			}
+		};
+
+		//encodes code points directly into a block buffer which is written to a sink in large writes
+		//a sink is anything with a member function bool write(void const *src, std::size_t n) which returns false on failure
+		//code units are written with native endianness
+		template<typename sink_t, typename code_unit_t = char>
+		class writer final
+		{
+			sink_t snk;
+			std::vector<code_unit_t> buffer;
+			std::size_t pos = 0;
+			bool ok = true;
+
+			//makes room for at least n more code units
+			void reserve(std::size_t const n)
+			{
+				if(buffer.size() - pos < n)
+				{
+					flush();
+					if(buffer.size() < n)
+					{
+						buffer.resize(n);
+					}
+				}
+			}
+
+		public:
+			static constexpr std::size_t default_block_size = std::size_t{1} << 16;
+
+			explicit writer(sink_t sink, std::size_t const block_size = default_block_size)
+			: snk(std::move(sink))
+			, buffer(block_size? block_size : 1)
+			{
+			}
+			writer(writer &&other)
+			: snk(std::move(other.snk))
+			, buffer(std::move(other.buffer))
+			, pos(other.pos)
+			, ok(other.ok)
+			{
+				other.pos = 0;
+			}
+			writer(writer const &) = delete;
+			writer &operator=(writer const &) = delete;
+			//flushes on a best-effort basis, errors and exceptions from the sink are swallowed so call flush() to see them
+			~writer()
+			{
+				try
+				{
+					flush();
+				}
+				catch(...)
+				{
+				}
+			}
+
+			//encodes a code point like encode_code_point
+			template<typename code_point_t>
+			void write(code_point_t const &cp)
+			{
+				using code_unit_ty = std::make_unsigned_t<code_unit_t>;
+				if(cp < static_cast<code_unit_ty>(code_unit_ty{0b1} << (sizeof(code_unit_ty)*CHAR_BIT-1)))
+				{
+					reserve(1);
+					buffer[pos++] = static_cast<code_unit_t>(cp);
+					return;
+				}
+				std::size_t const units = min_code_units<code_unit_t>(cp);
+				reserve(units);
+				encode_code_point<code_unit_t>(cp, buffer.data() + pos);
+				pos += units;
+			}
+
+			//copies already encoded code units
+			template<typename code_unit_iterator>
+			void write_code_units(code_unit_iterator first, code_unit_iterator const last)
+			{
+				for(; first != last; ++first)
+				{
+					if(pos == buffer.size())
+					{
+						flush();
+					}
+					buffer[pos++] = static_cast<code_unit_t>(*first);
+				}
+			}
+
+			//writes everything buffered so far to the sink, returns false if this or any previous write failed
+			auto flush()
+			-> bool
+			{
+				if(pos && ok)
+				{
+					ok = snk.write(buffer.data(), pos*sizeof(code_unit_t));
+				}
+				pos = 0;
+				return ok;
+			}
+
+			auto good() const noexcept
+			-> bool
+			{
+				return ok;
+			}
+
+			auto sink() noexcept
+			-> sink_t &
+			{
+				return snk;
+			}
+		};
+
+		template<typename code_unit_t = char>
+		auto make_writer(std::streambuf &buf, std::size_t const block_size = writer<streambuf_sink>::default_block_size)
+		-> writer<streambuf_sink, code_unit_t>
+		{
+			return writer<streambuf_sink, code_unit_t>{streambuf_sink{&buf}, block_size};
+		}
+		template<typename code_unit_t = char>
+		auto make_writer(std::ostream &out, std::size_t const block_size = writer<streambuf_sink>::default_block_size)
+		-> writer<streambuf_sink, code_unit_t>
+		{
+			return make_writer<code_unit_t>(*out.rdbuf(), block_size);
+		}
+		template<typename code_unit_t = char>
+		auto make_fd_writer(int const fd, std::size_t const block_size = writer<fd_sink>::default_block_size)
+		-> writer<fd_sink, code_unit_t>
+		{
+			return writer<fd_sink, code_unit_t>{fd_sink{fd}, block_size};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,582 @@
+#ifndef LB_utf_transcode_HeaderPlusPlus
+#define LB_utf_transcode_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace LB
+{
+	namespace utf
+	{
+		template<typename code_unit_iterator, typename output_iterator>
+		struct transcode_result final
+		{
+			//last, or the start of the first invalid sequence
+			code_unit_iterator in;
+			//one past the last code unit written
+			output_iterator out;
+		};
+
+		namespace detail
+		{
+			//pointers to integral code units of the given size can be written to by the kernels
+			template<typename output_iterator, std::size_t size>
+			using is_unit_pointer = std::integral_constant<bool,
+				std::is_pointer<output_iterator>::value
+			&&	std::is_integral<std::remove_pointer_t<output_iterator>>::value
+			&&	!std::is_const<std::remove_pointer_t<output_iterator>>::value
+			&&	sizeof(std::remove_pointer_t<output_iterator>) == size>;
+
+			//contiguous 32-bit code units can be narrowed by the kernels
+			template<typename code_unit_iterator>
+			using uses_wide_kernels = std::integral_constant<bool,
+				is_contiguous<code_unit_iterator>::value
+			&&	std::is_integral<typename std::iterator_traits<code_unit_iterator>::value_type>::value
+			&&	sizeof(typename std::iterator_traits<code_unit_iterator>::value_type) == 4>;
+
+			//whether the kernels can copy ASCII runs directly into the output
+			template<typename code_unit_iterator, typename output_iterator>
+			using copies_ascii = std::conditional_t<uses_byte_kernels<code_unit_iterator>::value,
+				is_unit_pointer<output_iterator, 4>,
+				std::integral_constant<bool, uses_wide_kernels<code_unit_iterator>::value && is_unit_pointer<output_iterator, 1>::value>>;
+
+			//the kernels take std::uint32_t, so other 32-bit code unit types such as char32_t, and raw storage, go through a buffer and std::memcpy rather than being aliased
+			constexpr std::size_t wide_chunk = 256;
+			inline auto widen_ascii(unsigned char const *p, std::size_t n, std::uint32_t *&out, std::true_type) noexcept
+			-> std::size_t
+			{
+				std::size_t const w = byte_kernels().widen_ascii(p, n, out);
+				out += w;
+				return w;
+			}
+			//writes 4 bytes for each code unit widened
+			inline auto widen_ascii(unsigned char const *p, std::size_t const n, void *const out, std::false_type) noexcept
+			-> std::size_t
+			{
+				unsigned char *const dst = static_cast<unsigned char *>(out);
+				std::uint32_t buffer[wide_chunk];
+				std::size_t done = 0;
+				while(done < n)
+				{
+					std::size_t const chunk = (n - done < wide_chunk)? n - done : wide_chunk;
+					std::size_t const w = byte_kernels().widen_ascii(p + done, chunk, buffer);
+					std::memcpy(dst + done*sizeof(std::uint32_t), buffer, w*sizeof(std::uint32_t));
+					done += w;
+					if(w < chunk)
+					{
+						break;
+					}
+				}
+				return done;
+			}
+			template<typename to_unit_t>
+			auto widen_ascii(unsigned char const *p, std::size_t const n, to_unit_t *&out, std::false_type) noexcept
+			-> std::size_t
+			{
+				std::size_t const w = widen_ascii(p, n, static_cast<void *>(out), std::false_type{});
+				out += w;
+				return w;
+			}
+			inline auto narrow_ascii(std::uint32_t const *p, std::size_t n, unsigned char *out, std::true_type) noexcept
+			-> std::size_t
+			{
+				return byte_kernels().narrow_ascii(p, n, out);
+			}
+			//reads 4 bytes for each code unit narrowed
+			inline auto narrow_ascii(void const *const p, std::size_t const n, unsigned char *out, std::false_type) noexcept
+			-> std::size_t
+			{
+				unsigned char const *const src = static_cast<unsigned char const *>(p);
+				std::uint32_t buffer[wide_chunk];
+				std::size_t done = 0;
+				while(done < n)
+				{
+					std::size_t const chunk = (n - done < wide_chunk)? n - done : wide_chunk;
+					std::memcpy(buffer, src + done*sizeof(std::uint32_t), chunk*sizeof(std::uint32_t));
+					std::size_t const w = byte_kernels().narrow_ascii(buffer, chunk, out + done);
+					done += w;
+					if(w < chunk)
+					{
+						break;
+					}
+				}
+				return done;
+			}
+
+			//copies the run of ASCII code units at it to out, returns how many
+			template<typename to_unit_t, typename code_unit_iterator, typename output_iterator>
+			auto copy_ascii(code_unit_iterator const it, code_unit_iterator const last, output_iterator &out, std::true_type, std::true_type) noexcept
+			-> std::size_t
+			{
+				return widen_ascii(to_bytes(it), static_cast<std::size_t>(last - it), out, std::is_same<std::remove_pointer_t<output_iterator>, std::uint32_t>{});
+			}
+			template<typename to_unit_t, typename code_unit_iterator, typename output_iterator>
+			auto copy_ascii(code_unit_iterator const it, code_unit_iterator const last, output_iterator &out, std::true_type, std::false_type)
+			-> std::size_t
+			{
+				unsigned char const *const p = to_bytes(it);
+				std::size_t const n = ascii_run(it, last, std::true_type{});
+				for(std::size_t i = 0; i < n; ++i, ++out)
+				{
+					*out = static_cast<to_unit_t>(p[i]);
+				}
+				return n;
+			}
+			template<typename to_unit_t, typename code_unit_iterator, typename output_iterator>
+			auto copy_ascii(code_unit_iterator const it, code_unit_iterator const last, output_iterator &out, std::false_type, std::true_type) noexcept
+			-> std::size_t
+			{
+				using from_unit_t = std::remove_cv_t<std::remove_reference_t<decltype(*it)>>;
+				std::size_t const n = narrow_ascii(&*it, static_cast<std::size_t>(last - it), reinterpret_cast<unsigned char *>(out), std::is_same<from_unit_t, std::uint32_t>{});
+				out += n;
+				return n;
+			}
+			template<typename to_unit_t, typename code_unit_iterator, typename output_iterator>
+			constexpr auto copy_ascii(code_unit_iterator const, code_unit_iterator const, output_iterator &, std::false_type, std::false_type) noexcept
+			-> std::size_t
+			{
+				return 0;
+			}
+
+			template<typename code_unit_iterator, typename output_iterator>
+			auto copy_validated(code_unit_iterator it, code_unit_iterator const last, output_iterator const out, std::true_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				auto const &k = byte_kernels();
+				unsigned char *const dest = reinterpret_cast<unsigned char *>(out);
+				unsigned char *o = dest;
+				bool ascii = true;
+				while(it != last)
+				{
+					if(ascii)
+					{
+						std::size_t const n = k.copy_ascii(to_bytes(it), static_cast<std::size_t>(last - it), o);
+						it += static_cast<std::ptrdiff_t>(n);
+						o += n;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					std::size_t const n = utf::num_code_units(it, last, true);
+					if(!n)
+					{
+						break;
+					}
+					std::memcpy(o, to_bytes(it), n);
+					it += static_cast<std::ptrdiff_t>(n);
+					o += n;
+					ascii = (n == 1);
+				}
+				return {it, out + (o - dest)};
+			}
+			template<typename code_unit_iterator, typename output_iterator>
+			auto copy_validated(code_unit_iterator it, code_unit_iterator const last, output_iterator out, std::false_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				while(it != last)
+				{
+					std::size_t n = utf::num_code_units(it, last, true);
+					if(!n)
+					{
+						break;
+					}
+					for(; n; --n, ++it, ++out)
+					{
+						*out = *it;
+					}
+				}
+				return {it, out};
+			}
+
+			//the number of code units up to the first invalid sequence, and where it is
+			template<typename to_unit_t, typename code_unit_iterator>
+			auto transcoded_size(code_unit_iterator it, code_unit_iterator const last)
+			-> std::pair<code_unit_iterator, std::size_t>
+			{
+				std::size_t size = 0;
+				bool ascii = true;
+				while(it != last)
+				{
+					if(ascii && uses_byte_kernels<code_unit_iterator>::value)
+					{
+						//every ASCII code point is a single code unit at any width
+						std::size_t const n = ascii_run(it, last, uses_byte_kernels<code_unit_iterator>{});
+						std::advance(it, n);
+						size += n;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second)
+					{
+						break;
+					}
+					it = r.first;
+					size += min_code_units<to_unit_t>(cp);
+					ascii = cp < 0x80u;
+				}
+				return {it, size};
+			}
+		}
+
+		//the number of to_unit_t code units transcode writes for [first, last), up to the first invalid sequence
+		//or the first code point wider than std::uintmax_t
+		template<typename to_unit_t, typename code_unit_iterator>
+		auto transcoded_size(code_unit_iterator const first, code_unit_iterator const last)
+		-> std::size_t
+		{
+			return detail::transcoded_size<to_unit_t>(first, last).second;
+		}
+
+		//the number of code units the same code points take at each code unit width
+		struct encoded_size final
+		{
+			std::size_t units8;
+			std::size_t units16;
+			std::size_t units32;
+			std::size_t units64;
+		};
+
+		namespace detail
+		{
+			//the number of bits needed to store v
+			constexpr auto significant_bits(std::uintmax_t v) noexcept
+			-> std::size_t
+			{
+				std::size_t bits = 0;
+				for(std::size_t step = std::numeric_limits<std::uintmax_t>::digits/2; step; step /= 2)
+				{
+					if(v >> step)
+					{
+						v >>= step;
+						bits += step;
+					}
+				}
+				return bits + (v != 0u);
+			}
+
+			//min_code_units only depends on how many bits the code point has, so it is looked up per bit count
+			using encoded_size_row = std::array<std::uint8_t, 4>;
+			inline auto encoded_size_table() noexcept
+			-> std::array<encoded_size_row, std::numeric_limits<std::uintmax_t>::digits + 1> const &
+			{
+				static auto const table = []
+				{
+					std::array<encoded_size_row, std::numeric_limits<std::uintmax_t>::digits + 1> t {};
+					for(std::size_t bits = 0; bits < t.size(); ++bits)
+					{
+						std::uintmax_t const cp = bits? std::uintmax_t{1} << (bits - 1) : 0u;
+						t[bits] = {{
+							static_cast<std::uint8_t>(min_code_units<std::uint8_t>(cp)),
+							static_cast<std::uint8_t>(min_code_units<std::uint16_t>(cp)),
+							static_cast<std::uint8_t>(min_code_units<std::uint32_t>(cp)),
+							static_cast<std::uint8_t>(min_code_units<std::uint64_t>(cp))
+						}};
+					}
+					return t;
+				}();
+				return table;
+			}
+
+			inline void add_encoded_size(encoded_size &size, std::uintmax_t const cp) noexcept
+			{
+				auto const &row = encoded_size_table()[significant_bits(cp)];
+				size.units8 += row[0];
+				size.units16 += row[1];
+				size.units32 += row[2];
+				size.units64 += row[3];
+			}
+			template<typename code_point_t>
+			void add_encoded_size(encoded_size &size, code_point_t const &cp)
+			{
+				size.units8 += min_code_units<std::uint8_t>(cp);
+				size.units16 += min_code_units<std::uint16_t>(cp);
+				size.units32 += min_code_units<std::uint32_t>(cp);
+				size.units64 += min_code_units<std::uint64_t>(cp);
+			}
+
+			template<typename code_unit_iterator>
+			auto encoded_sizes(code_unit_iterator it, code_unit_iterator const last)
+			-> std::pair<code_unit_iterator, encoded_size>
+			{
+				encoded_size size {0, 0, 0, 0};
+				bool ascii = true;
+				while(it != last)
+				{
+					if(ascii && uses_byte_kernels<code_unit_iterator>::value)
+					{
+						//every ASCII code point is a single code unit at any width
+						std::size_t const n = ascii_run(it, last, uses_byte_kernels<code_unit_iterator>{});
+						std::advance(it, n);
+						size.units8 += n;
+						size.units16 += n;
+						size.units32 += n;
+						size.units64 += n;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second)
+					{
+						break;
+					}
+					it = r.first;
+					add_encoded_size(size, cp);
+					ascii = cp < 0x80u;
+				}
+				return {it, size};
+			}
+		}
+
+		//the number of code units transcode writes for [first, last) at each code unit width, up to the first invalid sequence
+		//computed in a single pass, so the smallest representation can be picked without encoding any of them
+		template<typename code_unit_iterator>
+		auto encoded_sizes(code_unit_iterator const first, code_unit_iterator const last)
+		-> encoded_size
+		{
+			return detail::encoded_sizes(first, last).second;
+		}
+
+		//the number of code units the code points in [first, last) take when encoded at each code unit width
+		//code points must be of an unsigned type, or a class type which behaves like one
+		template<typename code_point_iterator>
+		auto encoded_sizes_of_code_points(code_point_iterator first, code_point_iterator const last)
+		-> encoded_size
+		{
+			using code_point_t = typename std::iterator_traits<code_point_iterator>::value_type;
+			static_assert(!std::is_signed<code_point_t>::value, "code points must be unsigned, a negative value has no encoding");
+			using fits_table = std::integral_constant<bool, std::is_unsigned<code_point_t>::value && sizeof(code_point_t) <= sizeof(std::uintmax_t)>;
+			encoded_size size {0, 0, 0, 0};
+			for(; first != last; ++first)
+			{
+				detail::add_encoded_size(size, std::conditional_t<fits_table::value, std::uintmax_t, code_point_t const &>(*first));
+			}
+			return size;
+		}
+
+		//re-encodes code units of one width as code units of another in a single pass,
+		//stopping at the first invalid sequence
+		//each code point is decoded into std::uintmax_t, so a valid sequence for a wider value also stops it, and the result's in refers to it
+		template<typename to_unit_t, typename code_unit_iterator, typename output_iterator>
+		auto transcode(code_unit_iterator it, code_unit_iterator const last, output_iterator out)
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			using byte_input = detail::uses_byte_kernels<code_unit_iterator>;
+			using copies_ascii = detail::copies_ascii<code_unit_iterator, output_iterator>;
+			bool ascii = true;
+			while(it != last)
+			{
+				if(ascii && (byte_input::value || copies_ascii::value))
+				{
+					std::advance(it, detail::copy_ascii<to_unit_t>(it, last, out, byte_input{}, copies_ascii{}));
+					if(it == last)
+					{
+						break;
+					}
+				}
+				std::uintmax_t cp {};
+				auto const r = utf::read_code_point(it, last, cp);
+				if(!r.second)
+				{
+					break;
+				}
+				it = r.first;
+				out = encode_code_point<to_unit_t>(cp, out);
+				ascii = cp < 0x80u;
+			}
+			return {it, out};
+		}
+
+		//copies the code units of every valid sequence up to the first invalid one, in the same pass that validates them
+		//returns where it stopped, which is last if everything was valid, and one past the last code unit written
+		template<typename code_unit_iterator, typename output_iterator>
+		auto copy_validated(code_unit_iterator const first, code_unit_iterator const last, output_iterator const out)
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			return detail::copy_validated(first, last, out, std::integral_constant<bool, detail::uses_byte_kernels<code_unit_iterator>::value && detail::is_unit_pointer<output_iterator, 1>::value>{});
+		}
+
+		//transcodes into a string allocated once with the exact size, throws std::invalid_argument for invalid input
+		//or a code point wider than std::uintmax_t
+		template<typename to_unit_t, typename code_unit_iterator>
+		auto transcode(code_unit_iterator const first, code_unit_iterator const last)
+		-> std::basic_string<to_unit_t>
+		{
+			auto const size = detail::transcoded_size<to_unit_t>(first, last);
+			if(size.first != last)
+			{
+				throw std::invalid_argument("invalid UTF sequence");
+			}
+			std::basic_string<to_unit_t> str (size.second, to_unit_t{});
+			if(size.second)
+			{
+				transcode<to_unit_t>(first, last, &str[0]);
+			}
+			return str;
+		}
+
+		namespace detail
+		{
+			template<typename latin1_iterator>
+			auto count_high(latin1_iterator const first, latin1_iterator const last, std::true_type) noexcept
+			-> std::size_t
+			{
+				return (first == last)? 0 : byte_kernels().count_high(to_bytes(first), static_cast<std::size_t>(last - first));
+			}
+			template<typename latin1_iterator>
+			auto count_high(latin1_iterator first, latin1_iterator const last, std::false_type)
+			-> std::size_t
+			{
+				std::size_t high = 0;
+				for(; first != last; ++first)
+				{
+					high += (static_cast<unsigned char>(*first) >> 7);
+				}
+				return high;
+			}
+
+			template<typename latin1_iterator, typename output_iterator>
+			auto latin1_to_utf8(latin1_iterator const first, latin1_iterator const last, output_iterator const out, std::true_type) noexcept
+			-> output_iterator
+			{
+				if(first == last)
+				{
+					return out;
+				}
+				return out + static_cast<std::ptrdiff_t>(byte_kernels().latin1_to_utf8(to_bytes(first), static_cast<std::size_t>(last - first), reinterpret_cast<unsigned char *>(out)));
+			}
+			template<typename latin1_iterator, typename output_iterator>
+			auto latin1_to_utf8(latin1_iterator first, latin1_iterator const last, output_iterator out, std::false_type)
+			-> output_iterator
+			{
+				for(; first != last; ++first)
+				{
+					out = encode_code_point<char>(static_cast<unsigned char>(*first), out);
+				}
+				return out;
+			}
+
+			//code points above U+FF stop the conversion unless replace is set, then they are written as replacement
+			template<typename code_unit_iterator, typename output_iterator>
+			auto utf8_to_latin1(code_unit_iterator it, code_unit_iterator const last, output_iterator const out, bool const replace, char const replacement, std::true_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				auto const &k = byte_kernels();
+				unsigned char *const dest = reinterpret_cast<unsigned char *>(out);
+				unsigned char *o = dest;
+				while(it != last)
+				{
+					auto const converted = k.utf8_to_latin1(to_bytes(it), static_cast<std::size_t>(last - it), o);
+					it += static_cast<std::ptrdiff_t>(converted.read);
+					o += converted.written;
+					if(it == last)
+					{
+						break;
+					}
+					//longer, overlong or invalid sequences
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second || (cp > 0xFFu && !replace))
+					{
+						break;
+					}
+					it = r.first;
+					*o++ = (cp > 0xFFu)? static_cast<unsigned char>(replacement) : static_cast<unsigned char>(cp);
+				}
+				return {it, out + (o - dest)};
+			}
+			template<typename code_unit_iterator, typename output_iterator>
+			auto utf8_to_latin1(code_unit_iterator it, code_unit_iterator const last, output_iterator out, bool const replace, char const replacement, std::false_type)
+			-> transcode_result<code_unit_iterator, output_iterator>
+			{
+				while(it != last)
+				{
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second || (cp > 0xFFu && !replace))
+					{
+						break;
+					}
+					it = r.first;
+					*out = (cp > 0xFFu)? replacement : static_cast<char>(static_cast<unsigned char>(cp));
+					++out;
+				}
+				return {it, out};
+			}
+
+			//whether the kernels can convert between contiguous 8-bit code units and an 8-bit output pointer
+			template<typename code_unit_iterator, typename output_iterator>
+			using converts_bytes = std::integral_constant<bool, uses_byte_kernels<code_unit_iterator>::value && is_unit_pointer<output_iterator, 1>::value>;
+		}
+
+		//the number of UTF-8 code units latin1_to_utf8 writes for the Latin-1 characters in [first, last),
+		//which is one for each character plus one more for each from 0x80
+		template<typename latin1_iterator>
+		auto latin1_to_utf8_size(latin1_iterator const first, latin1_iterator const last)
+		-> std::size_t
+		{
+			return static_cast<std::size_t>(std::distance(first, last)) + detail::count_high(first, last, detail::uses_byte_kernels<latin1_iterator>{});
+		}
+
+		//encodes Latin-1 (ISO-8859-1) characters as UTF-8, the same as encode_code_point<char> on each of them
+		//every character is valid, so this cannot fail; returns one past the last code unit written
+		//a pointer out needs room for latin1_to_utf8_size(first, last) code units, since the kernels may store whole vectors
+		template<typename latin1_iterator, typename output_iterator>
+		auto latin1_to_utf8(latin1_iterator const first, latin1_iterator const last, output_iterator const out)
+		-> output_iterator
+		{
+			return detail::latin1_to_utf8(first, last, out, detail::converts_bytes<latin1_iterator, output_iterator>{});
+		}
+
+		//encodes into a string allocated once with the exact size
+		template<typename latin1_iterator>
+		auto latin1_to_utf8(latin1_iterator const first, latin1_iterator const last)
+		-> std::string
+		{
+			std::string str (latin1_to_utf8_size(first, last), '\0');
+			if(!str.empty())
+			{
+				latin1_to_utf8(first, last, &str[0]);
+			}
+			return str;
+		}
+
+		//decodes UTF-8 to Latin-1 (ISO-8859-1), the same as read_code_point, stopping at the first invalid sequence
+		//or the first code point above U+FF, which Latin-1 cannot represent
+		//returns where it stopped, which is last if everything was converted, and one past the last character written
+		//out needs room for a character per code point, which is at most last - first
+		template<typename code_unit_iterator, typename output_iterator>
+		auto utf8_to_latin1(code_unit_iterator const first, code_unit_iterator const last, output_iterator const out)
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			return detail::utf8_to_latin1(first, last, out, false, char{}, detail::converts_bytes<code_unit_iterator, output_iterator>{});
+		}
+		//writes replacement, such as '?', for each code point above U+FF instead of stopping there
+		template<typename code_unit_iterator, typename output_iterator>
+		auto utf8_to_latin1(code_unit_iterator const first, code_unit_iterator const last, output_iterator const out, char const replacement)
+		-> transcode_result<code_unit_iterator, output_iterator>
+		{
+			return detail::utf8_to_latin1(first, last, out, true, replacement, detail::converts_bytes<code_unit_iterator, output_iterator>{});
+		}
+	}
+}
+
+#endif
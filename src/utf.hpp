@@ -1,13 +1,16 @@
 #ifndef LB_utf_utf_HeaderPlusPlus
 #define LB_utf_utf_HeaderPlusPlus
 
+#include <array>
 #include <climits>
 #include <cstdint>
 #include <iterator>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace LB
 {
@@ -16,248 +19,782 @@ namespace LB
 		template<typename code_unit_iterator>
 		using unsigned_code_unit_t = std::make_unsigned_t<typename std::iterator_traits<code_unit_iterator>::value_type>;
 
+		//kinds of invalid sequences reported to instrumentation
+		enum struct error_kind
+		{
+			unexpected_continuation, //the sequence started with a 0b10 code unit
+			truncated,               //the sequence ended before all of its code units
+			not_continuation,        //a code unit which should have been a continuation was not
+			too_long                 //the sequence was longer than allowed, or its code point did not fit the code point type
+		};
+
+		//instrumentation policy which does nothing, the default for all functions
+		//custom policies must provide the same member functions
+		struct no_instrumentation final
+		{
+			//a sequence of this many code units was successfully decoded
+			constexpr void on_sequence(std::size_t) const noexcept
+			{
+			}
+			//a sequence was rejected
+			constexpr void on_error(error_kind) const noexcept
+			{
+			}
+			//a header overflowed into this many code units
+			constexpr void on_header_overflow(std::size_t) const noexcept
+			{
+			}
+			//a fast path had to hand over to the generic bit loop
+			constexpr void on_fallback() const noexcept
+			{
+			}
+		};
+
+		//a sentinel which is never reached, for input which is known to end with a code unit that is not a continuation
+		struct unreachable_sentinel final
+		{
+		};
 		template<typename code_unit_iterator>
-		auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify = false)
-		noexcept(noexcept(it == last) && noexcept(*it) && noexcept(++it))
-		-> std::size_t
+		constexpr auto operator==(code_unit_iterator const &, unreachable_sentinel) noexcept
+		-> bool
+		{
+			return false;
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator==(unreachable_sentinel, code_unit_iterator const &) noexcept
+		-> bool
+		{
+			return false;
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator!=(code_unit_iterator const &, unreachable_sentinel) noexcept
+		-> bool
 		{
-			if(it == last)
+			return true;
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator!=(unreachable_sentinel, code_unit_iterator const &) noexcept
+		-> bool
+		{
+			return true;
+		}
+
+		//a sentinel which is reached at a zero code unit, for NUL-terminated strings
+		struct null_sentinel final
+		{
+		};
+		template<typename code_unit_iterator>
+		constexpr auto operator==(code_unit_iterator const &it, null_sentinel)
+		noexcept(noexcept(*it == 0))
+		-> bool
+		{
+			return *it == 0;
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator==(null_sentinel, code_unit_iterator const &it)
+		noexcept(noexcept(*it == 0))
+		-> bool
+		{
+			return *it == 0;
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator!=(code_unit_iterator const &it, null_sentinel)
+		noexcept(noexcept(*it == 0))
+		-> bool
+		{
+			return !(*it == 0);
+		}
+		template<typename code_unit_iterator>
+		constexpr auto operator!=(null_sentinel, code_unit_iterator const &it)
+		noexcept(noexcept(*it == 0))
+		-> bool
+		{
+			return !(*it == 0);
+		}
+
+		namespace detail
+		{
+			//iterators whose code units are known to be stored contiguously
+			template<typename code_unit_iterator, typename = void>
+			struct is_contiguous final
+			: std::false_type
+			{
+			};
+			template<typename T>
+			struct is_contiguous<T *>
+			: std::true_type
+			{
+			};
+			template<typename code_unit_iterator>
+			struct is_contiguous<code_unit_iterator, std::enable_if_t<!std::is_pointer<code_unit_iterator>::value>>
+			: std::integral_constant<bool,
+				std::is_same<code_unit_iterator, typename std::basic_string<typename std::iterator_traits<code_unit_iterator>::value_type>::iterator>::value
+			||	std::is_same<code_unit_iterator, typename std::basic_string<typename std::iterator_traits<code_unit_iterator>::value_type>::const_iterator>::value
+			||	std::is_same<code_unit_iterator, typename std::vector<typename std::iterator_traits<code_unit_iterator>::value_type>::iterator>::value
+			||	std::is_same<code_unit_iterator, typename std::vector<typename std::iterator_traits<code_unit_iterator>::value_type>::const_iterator>::value>
+			{
+			};
+
+			//the number of code units declared by a header which fits in the first code unit,
+			//or 0 if the header overflows or the code unit is a continuation
+			template<typename code_unit_t>
+			constexpr auto lead_length(code_unit_t v)
+			noexcept
+			-> std::size_t
 			{
-				return 0;
+				constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
+				constexpr code_unit_t start = code_unit_t{0b1} << NUM_BITS-1;
+				if(!(v & start))
+				{
+					return 1;
+				}
+				std::size_t len = 0;
+				for(code_unit_t test = start; test && (v & test); test >>= 1)
+				{
+					++len;
+				}
+				return (len < 2 || len == NUM_BITS)? 0 : len;
 			}
 
-			using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
-			static constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
-			static constexpr code_unit_t start = code_unit_t{0b1} << NUM_BITS-1;
+			template<typename code_unit_t>
+			constexpr auto is_continuation(code_unit_t const cu) noexcept
+			-> bool
+			{
+				using code_unit_ty = std::make_unsigned_t<code_unit_t>;
+				constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
+				return (static_cast<code_unit_ty>(cu) >> (NUM_BITS-2)) == 0b10u;
+			}
+		}
 
-			code_unit_t v = static_cast<code_unit_t>(*it);
-			code_unit_t test = start;
+		template<typename code_unit_t, typename code_point_t>
+		constexpr auto min_code_units(code_point_t cp)
+		noexcept(noexcept(cp < std::make_unsigned_t<code_unit_t>{}) && noexcept(!(cp == 0u)) && noexcept(cp >>= std::size_t{}))
+		-> std::size_t
+		{
+			using code_unit_ty = std::make_unsigned_t<code_unit_t>;
+			constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
 
-			if(!(v & test)) //code point made of exactly one code unit
+			//no-op if we can fit the code point in a single code unit
+			if(cp < static_cast<code_unit_ty>(code_unit_ty{0b1} << NUM_BITS-1))
 			{
 				return 1;
 			}
-			else
+
+			//count the number of bits we have to store
+			std::size_t bits = 0;
+			while(!(cp == 0u))
+			{
+				cp >>= std::size_t{1};
+				++bits;
+			}
+
+			//calculate how many code units are needed to store these bits plus the header bits
+			std::size_t units = 2;
+			while(bits + (units+1 - (units + (units-1)/NUM_BITS)/NUM_BITS) + (units-1)*2 > units*NUM_BITS)
+			{
+				++units;
+			}
+
+			//add extra to avoid situations which are impossible to represent
+			//e.g. with 8 bit code units, we cannot represent 8, 15, 22, 29, etc.
+			if((units + (units-1)/NUM_BITS)%NUM_BITS == 0)
+			{
+				++units;
+			}
+
+			//TODO: explain the expression (units + (units-1)/NUM_BITS)
+
+			return units;
+		}
+
+		namespace detail
+		{
+			//the longest sequence needed for any value of code_point_t, or no limit if it is not an integral type
+			template<typename code_unit_t, typename code_point_t>
+			constexpr auto max_code_units_for() noexcept
+			-> std::size_t
+			{
+				return std::numeric_limits<code_point_t>::is_integer? min_code_units<code_unit_t>(std::numeric_limits<code_point_t>::max()) : std::numeric_limits<std::size_t>::max();
+			}
+
+			//whether shifting cp left by bits keeps all of its bits
+			template<typename code_point_t>
+			constexpr auto fits_shift(code_point_t const &cp, std::size_t const bits, std::true_type) noexcept
+			-> bool
+			{
+				return bits >= static_cast<std::size_t>(std::numeric_limits<code_point_t>::digits)? cp == 0u : !(cp >> (std::numeric_limits<code_point_t>::digits - bits));
+			}
+			template<typename code_point_t>
+			constexpr auto fits_shift(code_point_t const &, std::size_t, std::false_type) noexcept
+			-> bool
 			{
-				test >>= 1;
-				if(!(v & test)) //unexpected continuation
+				return true;
+			}
+		}
+
+		namespace detail
+		{
+			template<typename code_unit_iterator, typename sentinel_t, typename instrumentation_t>
+			constexpr auto generic_num_code_units(code_unit_iterator it, sentinel_t const last, bool verify, instrumentation_t &instrument, std::size_t const max_units = std::numeric_limits<std::size_t>::max())
+			noexcept(noexcept(it == last) && noexcept(*it) && noexcept(++it) && noexcept(instrument.on_error(error_kind{})) && noexcept(instrument.on_header_overflow(std::size_t{})))
+			-> std::size_t
+			{
+				if(it == last)
 				{
 					return 0;
 				}
-			}
 
-			//read the header to determine the length
-			std::size_t len = 1
-			,           skip_bytes = 1;
-			while(v & test)
-			{
-				if(test == 1) //end of current code unit
+				using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
+				constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
+				constexpr code_unit_t start = code_unit_t{0b1} << NUM_BITS-1;
+
+				code_unit_t v = static_cast<code_unit_t>(*it);
+				code_unit_t test = start;
+
+				if(!(v & test)) //code point made of exactly one code unit
 				{
-					test = start;
-					if(++it == last || !((v = static_cast<code_unit_t>(*it)) & test)) //unexpected end of sequence
+					return 1;
+				}
+				else
+				{
+					test >>= 1;
+					if(!(v & test)) //unexpected continuation
 					{
+						instrument.on_error(error_kind::unexpected_continuation);
 						return 0;
 					}
-					else
+				}
+
+				//read the header to determine the length
+				std::size_t len = 1
+				,           skip_bytes = 1;
+				while(v & test)
+				{
+					if(test == 1) //end of current code unit
 					{
-						test >>= 1;
-						if(v & test) //should have been a continuation but wasn't
+						test = start;
+						if(++it == last) //unexpected end of sequence
 						{
+							instrument.on_error(error_kind::truncated);
 							return 0;
 						}
+						else if(!((v = static_cast<code_unit_t>(*it)) & test) || (v & (test >> 1))) //should have been a continuation but wasn't
+						{
+							instrument.on_error(error_kind::not_continuation);
+							return 0;
+						}
+						test >>= 1;
+						++len;
+						++skip_bytes;
 					}
-					++len;
-					++skip_bytes;
-				}
-				++len;
-				test >>= 1;
-			}
-
-			if(verify)
-			{
-				//verify that the other continuation code units exist
-				for(std::size_t i = 0; i < len-skip_bytes; ++i)
-				{
-					test = start;
-					if(++it == last || !((v = static_cast<code_unit_t>(*it)) & test)) //unexpected end of sequence
+					if(++len > max_units) //reject as soon as the header says too much, rather than after reading all of it
 					{
+						instrument.on_error(error_kind::too_long);
 						return 0;
 					}
-					else
+					test >>= 1;
+				}
+				if(skip_bytes > 1)
+				{
+					instrument.on_header_overflow(skip_bytes);
+				}
+
+				if(verify)
+				{
+					//verify that the other continuation code units exist
+					for(std::size_t i = 0; i < len-skip_bytes; ++i)
 					{
-						test >>= 1;
-						if(v & test) //should have been a continuation but wasn't
+						test = start;
+						if(++it == last) //unexpected end of sequence
+						{
+							instrument.on_error(error_kind::truncated);
+							return 0;
+						}
+						else if(!((v = static_cast<code_unit_t>(*it)) & test) || (v & (test >> 1))) //should have been a continuation but wasn't
 						{
+							instrument.on_error(error_kind::not_continuation);
 							return 0;
 						}
 					}
 				}
-			}
 
-			return len;
+				return len;
+			}
 		}
 
-		template<typename code_unit_iterator, typename code_point_t>
-		auto read_code_point(code_unit_iterator it, code_unit_iterator const last, code_point_t &cp)
-		noexcept(noexcept(num_code_units(it, last)) && noexcept(it == last) && noexcept(*it) && noexcept(++it) && std::is_nothrow_copy_constructible<code_unit_iterator>::value && noexcept(cp = *it) && noexcept(cp = {}) && noexcept(cp <<= std::size_t{}) && noexcept(cp |= unsigned_code_unit_t<code_unit_iterator>{}))
-		-> std::pair<code_unit_iterator, std::size_t>
+		namespace detail
 		{
-			std::size_t const n = num_code_units(it, last);
-			if(n == 1)
+			template<typename code_unit_iterator, typename instrumentation_t>
+			constexpr auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify, instrumentation_t &instrument, std::size_t const max_units, std::false_type)
+			noexcept(noexcept(generic_num_code_units(it, last, verify, instrument)))
+			-> std::size_t
 			{
-				cp = *it;
-				++it;
+				return generic_num_code_units(it, last, verify, instrument, max_units);
 			}
-			else if(n)
+			template<typename code_unit_iterator, typename instrumentation_t>
+			constexpr auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify, instrumentation_t &instrument, std::size_t const max_units, std::true_type)
+			noexcept(noexcept(generic_num_code_units(it, last, verify, instrument)) && noexcept(generic_num_code_units(it, unreachable_sentinel{}, verify, instrument)) && noexcept(instrument.on_fallback()))
+			-> std::size_t
 			{
-				cp = {};
-
-				using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
-				static constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
-				code_unit_iterator const first = it;
-
-				std::size_t skip_bits = n+1
-				,           remaining = n;
-				while(skip_bits >= NUM_BITS)
+				if(it != last)
 				{
-					skip_bits -= NUM_BITS-1;
-					--remaining;
-					if(++it == last) //unexpected end of sequence
+					//only one bounds check is needed if the whole sequence is known to be in range
+					std::size_t const n = lead_length(static_cast<std::make_unsigned_t<typename std::iterator_traits<code_unit_iterator>::value_type>>(*it));
+					if(n && n <= static_cast<std::size_t>(last - it))
 					{
-						return {first, 0};
+						return generic_num_code_units(it, unreachable_sentinel{}, verify, instrument, max_units);
 					}
+					instrument.on_fallback();
 				}
+				return generic_num_code_units(it, last, verify, instrument, max_units);
+			}
+		}
 
-				code_unit_t v = static_cast<code_unit_t>(*it);
-				code_unit_t mask = (std::numeric_limits<code_unit_t>::max() >> skip_bits); //skip initial header
-				for(;;)
+		//rejects sequences longer than max_units code units as error_kind::too_long, without reading past that many header bits
+		template<typename code_unit_iterator, typename instrumentation_t>
+		constexpr auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify, instrumentation_t &&instrument, std::size_t const max_units)
+		noexcept(noexcept(detail::num_code_units(it, last, verify, instrument, max_units, detail::is_contiguous<code_unit_iterator>{})))
+		-> std::size_t
+		{
+			return detail::num_code_units(it, last, verify, instrument, max_units, detail::is_contiguous<code_unit_iterator>{});
+		}
+
+		template<typename code_unit_iterator, typename instrumentation_t>
+		constexpr auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify, instrumentation_t &&instrument)
+		noexcept(noexcept(num_code_units(it, last, verify, instrument, std::size_t{})))
+		-> std::size_t
+		{
+			return num_code_units(it, last, verify, instrument, std::numeric_limits<std::size_t>::max());
+		}
+
+		template<typename code_unit_iterator>
+		constexpr auto num_code_units(code_unit_iterator it, code_unit_iterator const last, bool verify = false)
+		noexcept(noexcept(num_code_units(it, last, verify, no_instrumentation{})))
+		-> std::size_t
+		{
+			return num_code_units(it, last, verify, no_instrumentation{});
+		}
+
+		//stops at a sentinel of a different type than the iterator, such as null_sentinel, which is compared against before reading each code unit
+		template<typename code_unit_iterator, typename sentinel_t, typename instrumentation_t>
+		constexpr auto num_code_units(code_unit_iterator it, sentinel_t const last, bool verify, instrumentation_t &&instrument)
+		noexcept(noexcept(detail::generic_num_code_units(it, last, verify, instrument)))
+		-> std::size_t
+		{
+			return detail::generic_num_code_units(it, last, verify, instrument);
+		}
+		template<typename code_unit_iterator, typename sentinel_t>
+		constexpr auto num_code_units(code_unit_iterator it, sentinel_t const last, bool verify = false)
+		noexcept(noexcept(num_code_units(it, last, verify, no_instrumentation{})))
+		-> std::size_t
+		{
+			return num_code_units(it, last, verify, no_instrumentation{});
+		}
+
+		namespace detail
+		{
+			template<typename code_unit_iterator, typename sentinel_t, typename code_point_t, typename instrumentation_t>
+			constexpr auto generic_read_code_point(code_unit_iterator it, sentinel_t const last, code_point_t &cp, instrumentation_t &instrument)
+			noexcept(noexcept(generic_num_code_units(it, last, false, instrument)) && noexcept(it == last) && noexcept(*it) && noexcept(++it) && std::is_nothrow_copy_constructible<code_unit_iterator>::value && noexcept(cp = *it) && noexcept(cp = {}) && noexcept(cp <<= std::size_t{}) && noexcept(cp |= unsigned_code_unit_t<code_unit_iterator>{}) && noexcept(instrument.on_sequence(std::size_t{})))
+			-> std::pair<code_unit_iterator, std::size_t>
+			{
+				std::size_t const n = generic_num_code_units(it, last, false, instrument, max_code_units_for<unsigned_code_unit_t<code_unit_iterator>, code_point_t>());
+				if(n == 1)
+				{
+					cp = *it;
+					++it;
+				}
+				else if(n)
 				{
-					cp <<= static_cast<std::size_t>(NUM_BITS-2);
-					cp |= static_cast<code_unit_t>(*it & mask);
-					mask = (std::numeric_limits<code_unit_t>::max() >> 2); //skip continuation header
+					cp = {};
 
-					--remaining, ++it;
-					if(!remaining)
-					{
-						break;
-					}
+					using code_unit_t = unsigned_code_unit_t<code_unit_iterator>;
+					constexpr std::size_t NUM_BITS = sizeof(code_unit_t)*CHAR_BIT;
+					code_unit_iterator const first = it;
 
-					if(it == last || !((v = static_cast<code_unit_t>(*it)) & (code_unit_t{0b1} << NUM_BITS-1))) //unexpected end of sequence
+					std::size_t skip_bits = n+1
+					,           remaining = n;
+					while(skip_bits >= NUM_BITS)
 					{
-						return {first, 0};
+						skip_bits -= NUM_BITS-1;
+						--remaining;
+						if(++it == last) //unexpected end of sequence
+						{
+							instrument.on_error(error_kind::truncated);
+							return {first, 0};
+						}
+						else if(!(static_cast<code_unit_t>(*it) & (code_unit_t{0b1} << NUM_BITS-1)) || (static_cast<code_unit_t>(*it) & (code_unit_t{0b1} << NUM_BITS-2))) //a header which fills its code units must still be followed by a continuation
+						{
+							instrument.on_error(error_kind::not_continuation);
+							return {first, 0};
+						}
 					}
-					else
+
+					code_unit_t v = static_cast<code_unit_t>(*it);
+					code_unit_t mask = (std::numeric_limits<code_unit_t>::max() >> skip_bits); //skip initial header
+					for(;;)
 					{
-						if(v & (code_unit_t{0b1} << NUM_BITS-2)) //should have been a continuation but wasn't
+						if(!fits_shift(cp, NUM_BITS-2, std::is_integral<code_point_t>{})) //a sequence of the longest allowed length can still hold a few too many bits
+						{
+							instrument.on_error(error_kind::too_long);
+							return {first, 0};
+						}
+						cp <<= static_cast<std::size_t>(NUM_BITS-2);
+						cp |= static_cast<code_unit_t>(*it & mask);
+						mask = (std::numeric_limits<code_unit_t>::max() >> 2); //skip continuation header
+
+						--remaining, ++it;
+						if(!remaining)
 						{
+							break;
+						}
+
+						if(it == last) //unexpected end of sequence
+						{
+							instrument.on_error(error_kind::truncated);
+							return {first, 0};
+						}
+						else if(!((v = static_cast<code_unit_t>(*it)) & (code_unit_t{0b1} << NUM_BITS-1)) || (v & (code_unit_t{0b1} << NUM_BITS-2))) //should have been a continuation but wasn't
+						{
+							instrument.on_error(error_kind::not_continuation);
 							return {first, 0};
 						}
 					}
 				}
+				if(n)
+				{
+					instrument.on_sequence(n);
+				}
+				return {it, n};
 			}
-			return {it, n};
 		}
 
-		template<typename code_unit_t, typename code_point_t>
-		constexpr auto min_code_units(code_point_t cp)
-		noexcept(noexcept(cp < std::make_unsigned_t<code_unit_t>{}) && noexcept(!(cp == 0u)) && noexcept(cp >>= std::size_t{}))
-		-> std::size_t
+		namespace detail
 		{
-			using code_unit_ty = std::make_unsigned_t<code_unit_t>;
-			constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
-
-			//no-op if we can fit the code point in a single code unit
-			if(cp < static_cast<code_unit_ty>(code_unit_ty{0b1} << NUM_BITS-1))
+			template<typename code_unit_iterator, typename code_point_t, typename instrumentation_t>
+			constexpr auto read_code_point(code_unit_iterator it, code_unit_iterator const last, code_point_t &cp, instrumentation_t &instrument, std::false_type)
+			noexcept(noexcept(generic_read_code_point(it, last, cp, instrument)))
+			-> std::pair<code_unit_iterator, std::size_t>
 			{
-				return 1;
+				return generic_read_code_point(it, last, cp, instrument);
+			}
+			template<typename code_unit_iterator, typename code_point_t, typename instrumentation_t>
+			constexpr auto read_code_point(code_unit_iterator it, code_unit_iterator const last, code_point_t &cp, instrumentation_t &instrument, std::true_type)
+			noexcept(noexcept(generic_read_code_point(it, last, cp, instrument)) && noexcept(generic_read_code_point(it, unreachable_sentinel{}, cp, instrument)) && noexcept(instrument.on_fallback()))
+			-> std::pair<code_unit_iterator, std::size_t>
+			{
+				if(it != last)
+				{
+					//only one bounds check is needed if the whole sequence is known to be in range
+					std::size_t const n = lead_length(static_cast<std::make_unsigned_t<typename std::iterator_traits<code_unit_iterator>::value_type>>(*it));
+					if(n && n <= static_cast<std::size_t>(last - it))
+					{
+						return generic_read_code_point(it, unreachable_sentinel{}, cp, instrument);
+					}
+					instrument.on_fallback();
+				}
+				return generic_read_code_point(it, last, cp, instrument);
 			}
+		}
 
-			//count the number of bits we have to store
-			std::size_t bits = 0;
-			while(!(cp == 0u))
+		template<typename code_unit_iterator, typename code_point_t, typename instrumentation_t>
+		constexpr auto read_code_point(code_unit_iterator it, code_unit_iterator const last, code_point_t &cp, instrumentation_t &&instrument)
+		noexcept(noexcept(detail::read_code_point(it, last, cp, instrument, detail::is_contiguous<code_unit_iterator>{})))
+		-> std::pair<code_unit_iterator, std::size_t>
+		{
+			return detail::read_code_point(it, last, cp, instrument, detail::is_contiguous<code_unit_iterator>{});
+		}
+
+		template<typename code_unit_iterator, typename code_point_t>
+		constexpr auto read_code_point(code_unit_iterator it, code_unit_iterator const last, code_point_t &cp)
+		noexcept(noexcept(read_code_point(it, last, cp, no_instrumentation{})))
+		-> std::pair<code_unit_iterator, std::size_t>
+		{
+			return read_code_point(it, last, cp, no_instrumentation{});
+		}
+
+		//stops at a sentinel of a different type than the iterator, see num_code_units
+		template<typename code_unit_iterator, typename sentinel_t, typename code_point_t, typename instrumentation_t>
+		constexpr auto read_code_point(code_unit_iterator it, sentinel_t const last, code_point_t &cp, instrumentation_t &&instrument)
+		noexcept(noexcept(detail::generic_read_code_point(it, last, cp, instrument)))
+		-> std::pair<code_unit_iterator, std::size_t>
+		{
+			return detail::generic_read_code_point(it, last, cp, instrument);
+		}
+		template<typename code_unit_iterator, typename sentinel_t, typename code_point_t>
+		constexpr auto read_code_point(code_unit_iterator it, sentinel_t const last, code_point_t &cp)
+		noexcept(noexcept(read_code_point(it, last, cp, no_instrumentation{})))
+		-> std::pair<code_unit_iterator, std::size_t>
+		{
+			return read_code_point(it, last, cp, no_instrumentation{});
+		}
+
+		//decoding without an end, for input which is known to be followed by a code unit that is not a continuation,
+		//e.g. zeroes in a padded_buffer, or a NUL terminator - sequences cut off by it are rejected as error_kind::not_continuation
+		namespace unchecked
+		{
+			template<typename code_unit_iterator, typename instrumentation_t>
+			constexpr auto num_code_units(code_unit_iterator it, bool verify, instrumentation_t &&instrument)
+			noexcept(noexcept(detail::generic_num_code_units(it, unreachable_sentinel{}, verify, instrument)))
+			-> std::size_t
 			{
-				cp >>= std::size_t{1};
-				++bits;
+				return detail::generic_num_code_units(it, unreachable_sentinel{}, verify, instrument);
+			}
+			template<typename code_unit_iterator>
+			constexpr auto num_code_units(code_unit_iterator it, bool verify = false)
+			noexcept(noexcept(num_code_units(it, verify, no_instrumentation{})))
+			-> std::size_t
+			{
+				return num_code_units(it, verify, no_instrumentation{});
 			}
 
-			//calculate how many code units are needed to store these bits plus the header bits
-			std::size_t units = 2;
-			while(bits + (units+1 - (units + (units-1)/NUM_BITS)/NUM_BITS) + (units-1)*2 > units*NUM_BITS)
+			template<typename code_unit_iterator, typename code_point_t, typename instrumentation_t>
+			constexpr auto read_code_point(code_unit_iterator it, code_point_t &cp, instrumentation_t &&instrument)
+			noexcept(noexcept(detail::generic_read_code_point(it, unreachable_sentinel{}, cp, instrument)))
+			-> std::pair<code_unit_iterator, std::size_t>
 			{
-				++units;
+				return detail::generic_read_code_point(it, unreachable_sentinel{}, cp, instrument);
+			}
+			template<typename code_unit_iterator, typename code_point_t>
+			constexpr auto read_code_point(code_unit_iterator it, code_point_t &cp)
+			noexcept(noexcept(read_code_point(it, cp, no_instrumentation{})))
+			-> std::pair<code_unit_iterator, std::size_t>
+			{
+				return read_code_point(it, cp, no_instrumentation{});
 			}
+		}
 
-			//add extra to avoid situations which are impossible to represent
-			//e.g. with 8 bit code units, we cannot represent 8, 15, 22, 29, etc.
-			if((units + (units-1)/NUM_BITS)%NUM_BITS == 0)
+		namespace detail
+		{
+			//shifts right without undefined behavior for primitive types when n is at least their width
+			template<typename code_point_t>
+			constexpr auto shift_right(code_point_t cp, std::size_t const n, std::true_type)
+			noexcept
+			-> code_point_t
 			{
-				++units;
+				return n >= static_cast<std::size_t>(std::numeric_limits<code_point_t>::digits)? code_point_t{0} : static_cast<code_point_t>(cp >> n);
+			}
+			template<typename code_point_t>
+			constexpr auto shift_right(code_point_t cp, std::size_t const n, std::false_type)
+			noexcept(noexcept(cp >>= std::size_t{}))
+			-> code_point_t
+			{
+				cp >>= n;
+				return cp;
 			}
 
-			//TODO: explain the expression (units + (units-1)/NUM_BITS)
+			//the header bits of the code unit at the given index of a sequence of the given length
+			template<typename code_unit_ty>
+			constexpr auto header_bits(std::size_t const units, std::size_t const index)
+			noexcept
+			-> code_unit_ty
+			{
+				constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
+				if(index == 0)
+				{
+					if(units < NUM_BITS)
+					{
+						return static_cast<code_unit_ty>(std::numeric_limits<code_unit_ty>::max() << (NUM_BITS - units));
+					}
+					return std::numeric_limits<code_unit_ty>::max();
+				}
 
-			return units;
+				code_unit_ty cu = static_cast<code_unit_ty>(code_unit_ty{0b1} << NUM_BITS-1);
+				if(units >= NUM_BITS)
+				{
+					//the header overflowed, continue it after the continuation headers
+					std::size_t bits = units-NUM_BITS;
+					bits -= (bits-1)/(NUM_BITS-2) + 1; //include continuation header bits
+					std::size_t const start = (index-1)*(NUM_BITS-2);
+					if(start < bits)
+					{
+						std::size_t const count = (bits-start < NUM_BITS-2)? bits-start : NUM_BITS-2;
+						cu |= static_cast<code_unit_ty>(static_cast<code_unit_ty>((code_unit_ty{0b1} << count) - 1u) << (NUM_BITS-2 - count));
+					}
+				}
+				return cu;
+			}
+
+			//the low NUM_BITS-2 bits of the code point after shifting it right
+			template<typename code_unit_ty, typename code_point_t>
+			constexpr auto payload_bits(code_point_t cp, std::size_t const shift, std::true_type)
+			noexcept
+			-> code_unit_ty
+			{
+				cp = shift_right(cp, shift, std::true_type{});
+				return static_cast<code_unit_ty>(cp & static_cast<code_point_t>(std::numeric_limits<code_unit_ty>::max() >> 2));
+			}
+			template<typename code_unit_ty, typename code_point_t>
+			constexpr auto payload_bits(code_point_t cp, std::size_t const shift, std::false_type)
+			noexcept(noexcept(cp >>= std::size_t{}) && noexcept(cp & 0b1) && noexcept(!(cp == 0u)))
+			-> code_unit_ty
+			{
+				constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
+				cp = shift_right(cp, shift, std::false_type{});
+				code_unit_ty cu = 0;
+				for(std::size_t i = 0; i < NUM_BITS-2 && !(cp == 0u); ++i)
+				{
+					if(cp & 0b1)
+					{
+						cu |= static_cast<code_unit_ty>(code_unit_ty{0b1} << i);
+					}
+					cp >>= std::size_t{1};
+				}
+				return cu;
+			}
 		}
 
-		template<typename code_unit_t, typename code_point_t>
-		auto encode_code_point(code_point_t cp)
-		-> std::basic_string<code_unit_t>
+		template<typename code_unit_t, typename code_point_t, typename code_unit_output_iterator>
+		constexpr auto encode_code_point(code_point_t cp, code_unit_output_iterator out)
+		-> code_unit_output_iterator
 		{
 			using code_unit_ty = std::make_unsigned_t<std::remove_cv_t<std::remove_reference_t<code_unit_t>>>;
-			static constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
+			constexpr std::size_t NUM_BITS = sizeof(code_unit_ty)*CHAR_BIT;
 
 			std::size_t const units = min_code_units<code_unit_t>(cp);
 			if(units == 1)
 			{
-				return {static_cast<code_unit_t>(cp)};
+				*out = static_cast<code_unit_t>(cp);
+				++out;
+				return out;
 			}
 
-			std::basic_string<code_unit_t> code_units (units, code_unit_t{});
-
-			//set continuation headers
-			for(std::size_t i = 1; i < code_units.size(); ++i)
+			//the header bits never overlap the code point, since min_code_units left room for them
+			for(std::size_t i = 0; i < units; ++i)
 			{
-				code_units[i] = static_cast<code_unit_t>(code_unit_ty{0b1} << NUM_BITS-1);
+				*out = static_cast<code_unit_t>(detail::header_bits<code_unit_ty>(units, i) | detail::payload_bits<code_unit_ty>(cp, (units-1-i)*(NUM_BITS-2), std::is_integral<code_point_t>{}));
+				++out;
 			}
+			return out;
+		}
 
-			//fill header bits
-			if(code_units.size() < NUM_BITS)
+		template<typename code_unit_t, typename code_point_t>
+		auto encode_code_point(code_point_t cp)
+		-> std::basic_string<code_unit_t>
+		{
+			std::basic_string<code_unit_t> code_units;
+			code_units.reserve(min_code_units<code_unit_t>(cp));
+			encode_code_point<code_unit_t>(cp, std::back_inserter(code_units));
+			return code_units;
+		}
+
+		namespace detail
+		{
+			template<typename T, std::size_t N>
+			struct constexpr_buffer final
+			{
+				T data[N? N : 1];
+			};
+
+			template<typename T, std::size_t N, std::size_t... I>
+			constexpr auto to_array(constexpr_buffer<T, N> const &buffer, std::index_sequence<I...>)
+			noexcept
+			-> std::array<T, N>
 			{
-				code_units[0] = static_cast<code_unit_t>(std::numeric_limits<code_unit_ty>::max() << (NUM_BITS - code_units.size()));
+				return {{buffer.data[I]...}};
 			}
-			else
+
+			template<typename code_unit_t, std::uintmax_t cp>
+			constexpr auto encode_to_buffer()
+			noexcept
+			-> constexpr_buffer<code_unit_t, min_code_units<code_unit_t>(cp)>
 			{
-				code_units[0] = static_cast<code_unit_t>(std::numeric_limits<code_unit_ty>::max());
-				std::size_t bits = code_units.size()-NUM_BITS;
-				bits -= (bits-1)/(NUM_BITS-2) + 1; //include continuation header bits
-				for(std::size_t i = 0; i < bits; ++i)
-				{
-					code_unit_ty &cu = reinterpret_cast<code_unit_ty &>(code_units[1 + i/(NUM_BITS-2)]);
-					cu |= (code_unit_ty{0b1} << ((NUM_BITS-3) - i%(NUM_BITS-2)));
-				}
+				constexpr_buffer<code_unit_t, min_code_units<code_unit_t>(cp)> buffer {};
+				encode_code_point<code_unit_t>(cp, buffer.data);
+				return buffer;
 			}
 
-			//store code point
-			auto it = std::rbegin(code_units);
-			std::size_t shift = 0;
-			while(!(cp == 0u))
+			template<typename code_unit_t>
+			constexpr auto count_code_points(code_unit_t const *it, code_unit_t const *const last)
+			-> std::size_t
 			{
-				code_unit_ty &cu = reinterpret_cast<code_unit_ty &>(*it);
-				if(cp & 0b1)
+				std::size_t n = 0;
+				while(it != last)
 				{
-					cu |= static_cast<code_unit_ty>(code_unit_ty{0b1} << shift);
+					std::uintmax_t cp {};
+					auto const r = utf::read_code_point(it, last, cp);
+					if(!r.second)
+					{
+						//in a constant expression this is a compile error
+						throw std::invalid_argument("invalid UTF sequence");
+					}
+					it = r.first;
+					++n;
 				}
-				cp >>= std::size_t{1};
+				return n;
+			}
 
-				if(++shift >= NUM_BITS-2)
+			template<typename code_point_t, std::size_t N, typename code_unit_t>
+			constexpr auto decode_to_buffer(code_unit_t const *it, code_unit_t const *const last)
+			-> constexpr_buffer<code_point_t, N>
+			{
+				constexpr_buffer<code_point_t, N> buffer {};
+				for(std::size_t i = 0; i < N; ++i)
 				{
-					++it;
-					shift = 0;
+					if(it == last)
+					{
+						throw std::length_error("fewer code points than requested");
+					}
+					auto const r = utf::read_code_point(it, last, buffer.data[i]);
+					if(!r.second)
+					{
+						throw std::invalid_argument("invalid UTF sequence");
+					}
+					it = r.first;
 				}
+				return buffer;
 			}
 
-			return code_units;
+			template<typename code_unit_t, code_unit_t... code_units>
+			struct static_code_units final
+			{
+				static constexpr code_unit_t data[sizeof...(code_units)? sizeof...(code_units) : 1] = {code_units...};
+				static constexpr std::size_t size = sizeof...(code_units);
+				static constexpr std::size_t num_code_points = count_code_points(data, data + size);
+			};
+			template<typename code_unit_t, code_unit_t... code_units>
+			constexpr code_unit_t static_code_units<code_unit_t, code_units...>::data[];
+		}
+
+		//encodes a code point at compile time
+		template<typename code_unit_t, std::uintmax_t cp>
+		constexpr auto encode_code_point_array()
+		noexcept
+		-> std::array<code_unit_t, min_code_units<code_unit_t>(cp)>
+		{
+			constexpr std::size_t N = min_code_units<code_unit_t>(cp);
+			return detail::to_array(detail::encode_to_buffer<code_unit_t, cp>(), std::make_index_sequence<N>{});
 		}
+
+		//decodes exactly N code points, usable in constant expressions
+		template<std::size_t N, typename code_point_t = char32_t, typename code_unit_t>
+		constexpr auto decode_code_points(code_unit_t const *first, code_unit_t const *const last)
+		-> std::array<code_point_t, N>
+		{
+			return detail::to_array(detail::decode_to_buffer<code_point_t, N>(first, last), std::make_index_sequence<N>{});
+		}
+
+#if defined(__GNUC__)
+		namespace literals
+		{
+	#pragma GCC diagnostic push
+	#ifdef __clang__
+		#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+	#else
+		#pragma GCC diagnostic ignored "-Wpedantic"
+	#endif
+			//u8"..."_cp decodes a string literal into a std::array of code points at compile time
+			//this relies on string literal operator templates, a GNU extension supported by GCC and Clang
+			template<typename code_unit_t, code_unit_t... code_units>
+			constexpr auto operator""_cp()
+			-> std::array<char32_t, detail::static_code_units<code_unit_t, code_units...>::num_code_points>
+			{
+				using units = detail::static_code_units<code_unit_t, code_units...>;
+				return decode_code_points<units::num_code_points>(units::data, units::data + units::size);
+			}
+	#pragma GCC diagnostic pop
+		}
+#endif
 	}
 }
 
@@ -0,0 +1,142 @@
+#ifndef LB_utf_width_HeaderPlusPlus
+#define LB_utf_width_HeaderPlusPlus
+
+#include "simd.hpp"
+#include "utf.hpp"
+#include "width_table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace LB
+{
+	namespace utf
+	{
+		//the number of terminal columns a code point occupies: 0, 1, or 2
+		//code points above U+10FFFF occupy 1 column, as whatever replaces them would
+		template<typename code_point_t>
+		auto width(code_point_t const &cp) noexcept
+		-> std::size_t
+		{
+			if(!(cp < 0x110000u))
+			{
+				return 1;
+			}
+			std::uint32_t const v = static_cast<std::uint32_t>(cp);
+			constexpr std::uint32_t block_mask = (std::uint32_t{1} << detail::width_block_bits) - 1;
+			std::size_t const block = detail::width_stage1()[v >> detail::width_block_bits];
+			std::uint8_t const packed = detail::width_stage2()[(block << detail::width_block_bits)/4 + (v & block_mask)/4];
+			return (packed >> ((v & 0b11u)*2)) & 0b11u;
+		}
+
+		//what measure_display found
+		struct display_extent final
+		{
+			std::size_t code_points;
+			std::size_t width;
+		};
+
+		namespace detail
+		{
+			//the code units which are not printable ASCII
+			inline auto width_specials() noexcept
+			-> simd::byte_set const &
+			{
+				static simd::byte_set const set = []
+				{
+					simd::byte_set s {};
+					for(unsigned b = 0; b < 0x20u; ++b)
+					{
+						s.insert(static_cast<unsigned char>(b));
+					}
+					for(unsigned b = 0x7Fu; b < 0x100u; ++b)
+					{
+						s.insert(static_cast<unsigned char>(b));
+					}
+					return s;
+				}();
+				return set;
+			}
+
+			//adds the code point or invalid sequence at it, returns where the next one starts
+			template<typename code_unit_iterator>
+			auto measure_one(code_unit_iterator it, code_unit_iterator const last, display_extent &extent, bool &printable_ascii)
+			-> code_unit_iterator
+			{
+				std::uintmax_t cp {};
+				auto const r = utf::read_code_point(it, last, cp);
+				++extent.code_points;
+				if(!r.second)
+				{
+					//shown as a replacement character
+					++extent.width;
+					printable_ascii = false;
+					return ++it;
+				}
+				extent.width += utf::width(cp);
+				printable_ascii = (cp >= 0x20u && cp < 0x7Fu);
+				return r.first;
+			}
+
+			template<typename code_unit_iterator>
+			auto measure_display(code_unit_iterator it, code_unit_iterator const last, std::true_type)
+			-> display_extent
+			{
+				display_extent extent {0, 0};
+				auto const &k = byte_kernels();
+				auto const &specials = width_specials();
+				bool printable_ascii = true;
+				while(it != last)
+				{
+					if(printable_ascii)
+					{
+						//every printable ASCII code point is one code unit and one column
+						std::size_t const n = k.find_in_set(to_bytes(it), static_cast<std::size_t>(last - it), specials);
+						it += static_cast<std::ptrdiff_t>(n);
+						extent.code_points += n;
+						extent.width += n;
+						if(it == last)
+						{
+							break;
+						}
+					}
+					it = measure_one(it, last, extent, printable_ascii);
+				}
+				return extent;
+			}
+			template<typename code_unit_iterator>
+			auto measure_display(code_unit_iterator it, code_unit_iterator const last, std::false_type)
+			-> display_extent
+			{
+				display_extent extent {0, 0};
+				bool printable_ascii;
+				while(it != last)
+				{
+					it = measure_one(it, last, extent, printable_ascii);
+				}
+				return extent;
+			}
+		}
+
+		//counts the code points and sums their widths in a single pass
+		//each code unit of an invalid sequence counts as one code point of width 1
+		template<typename code_unit_iterator>
+		auto measure_display(code_unit_iterator const first, code_unit_iterator const last)
+		-> display_extent
+		{
+			return detail::measure_display(first, last, detail::uses_byte_kernels<code_unit_iterator>{});
+		}
+
+		//the number of terminal columns the code units occupy, see measure_display
+		template<typename code_unit_iterator>
+		auto display_width(code_unit_iterator const first, code_unit_iterator const last)
+		-> std::size_t
+		{
+			return measure_display(first, last).width;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "advance.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::size_t output, std::size_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//the contiguous paths must agree with the generic ones for every starting position and count, even on invalid input
+template<typename code_unit_t>
+void run_tests(std::basic_string<code_unit_t> const &str, std::vector<std::size_t> const &counts)
+{
+	std::list<code_unit_t> const list (std::cbegin(str), std::cend(str));
+	for(std::size_t start = 0; start <= str.size(); start += 1 + start/16)
+	{
+		auto const first = std::cbegin(str) + static_cast<std::ptrdiff_t>(start);
+		auto const lit = std::next(std::cbegin(list), static_cast<std::ptrdiff_t>(start));
+		std::size_t const expected_distance = LB::utf::distance(lit, std::cend(list));
+		check("distance", LB::utf::distance(first, std::cend(str)), expected_distance);
+		for(std::size_t const n : counts)
+		{
+			auto it = first;
+			auto expected = lit;
+			std::size_t const expected_left = LB::utf::advance(expected, std::cend(list), n);
+			check("advance remainder", LB::utf::advance(it, std::cend(str), n), expected_left);
+			check("advance position", static_cast<std::size_t>(it - std::cbegin(str)), static_cast<std::size_t>(std::distance(std::cbegin(list), expected)));
+			check("advance remainder matches distance", expected_left, n > expected_distance? n - expected_distance : 0);
+			check("next", static_cast<std::size_t>(LB::utf::next(first, std::cend(str), n) - std::cbegin(str)), static_cast<std::size_t>(it - std::cbegin(str)));
+		}
+	}
+}
+
+int main()
+{
+	//ASCII, two units, overflowed headers
+	std::string const valid = "ab" + LB::utf::encode_code_point<char>(0xE9u) + "c" + LB::utf::encode_code_point<char>(std::uintmax_t{1} << 41) + "d";
+	{
+		auto it = std::cbegin(valid);
+		check("single code points", LB::utf::advance(it, std::cend(valid), 3), 0);
+		check("single code points position", static_cast<std::size_t>(it - std::cbegin(valid)), 4);
+		check("skip overflowed header", static_cast<std::size_t>(LB::utf::next(it, std::cend(valid), 2) - std::cbegin(valid)), valid.size() - 1);
+		check("past the end", LB::utf::advance(it, std::cend(valid), 10), 7);
+		check("distance", LB::utf::distance(std::cbegin(valid), std::cend(valid)), 6);
+	}
+
+	//long enough to use the kernels, with random bytes for invalid sequences
+	std::mt19937 gen {33};
+	std::string mixed;
+	for(int i = 0; i < 200; ++i)
+	{
+		mixed += valid;
+		mixed += std::string(gen() % 300, 'x');
+		mixed += static_cast<char>(gen());
+	}
+	std::vector<std::size_t> const counts {0, 1, 2, 5, 100, 255, 256, 257, 1000, 5000, 100000};
+	run_tests(valid, counts);
+	run_tests(mixed, counts);
+	run_tests(std::u16string(u"aé\U0001F600b"), counts);
+
+	return result;
+}
@@ -0,0 +1,145 @@
+#include "batch.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//builds an Arrow-style column with some unrelated code units in front, so offsets do not start at 0
+template<typename code_unit_t>
+void make_column(std::vector<std::basic_string<code_unit_t>> const &strings, std::basic_string<code_unit_t> &data, std::vector<std::int32_t> &offsets)
+{
+	data.assign(3, static_cast<code_unit_t>('z'));
+	offsets.assign(1, static_cast<std::int32_t>(data.size()));
+	for(auto const &s : strings)
+	{
+		data += s;
+		offsets.push_back(static_cast<std::int32_t>(data.size()));
+	}
+}
+
+template<typename code_unit_t>
+void run_tests(std::string const &name, std::vector<std::basic_string<code_unit_t>> const &strings)
+{
+	std::basic_string<code_unit_t> data;
+	std::vector<std::int32_t> offsets;
+	make_column(strings, data, offsets);
+
+	std::vector<std::size_t> valid;
+	std::size_t invalid = 0;
+	for(auto const &s : strings)
+	{
+		valid.push_back(static_cast<std::size_t>(LB::utf::validate(std::cbegin(s), std::cend(s)) - std::cbegin(s)));
+		invalid += (valid.back() != s.size());
+	}
+	std::vector<std::size_t> got;
+	check(name + " invalid strings", LB::utf::validate_batch(std::cbegin(data), std::cbegin(offsets), std::cend(offsets), std::back_inserter(got)), invalid);
+	check(name + " validated strings", got.size(), strings.size());
+	for(std::size_t i = 0; i < got.size() && i < strings.size(); ++i)
+	{
+		check(name + " valid units " + std::to_string(i), got[i], valid[i]);
+	}
+
+	std::size_t total = 0;
+	got.clear();
+	check(name + " total code points", LB::utf::count_code_points_batch(data.data(), std::cbegin(offsets), std::cend(offsets), std::back_inserter(got)), [&]
+	{
+		for(auto const &s : strings)
+		{
+			total += LB::utf::count_code_points(std::cbegin(s), std::cend(s));
+		}
+		return total;
+	}());
+	for(std::size_t i = 0; i < got.size() && i < strings.size(); ++i)
+	{
+		check(name + " code points " + std::to_string(i), got[i], LB::utf::count_code_points(std::cbegin(strings[i]), std::cend(strings[i])));
+	}
+
+	//a pointer to 32-bit code points and a generic output iterator take different paths
+	std::vector<std::uint32_t> cps (total);
+	std::vector<std::uintmax_t> generic;
+	std::vector<LB::utf::batch_string> info, generic_info;
+	std::uint32_t *const end = LB::utf::decode_batch<std::uint32_t>(std::cbegin(data), std::cbegin(offsets), std::cend(offsets), cps.data(), std::back_inserter(info));
+	LB::utf::decode_batch(data.data(), offsets.data(), offsets.data() + offsets.size(), std::back_inserter(generic), std::back_inserter(generic_info));
+	check(name + " decoded strings", info.size(), strings.size());
+	check(name + " decoded strings generic", generic_info.size(), strings.size());
+	std::vector<std::uint32_t> expected;
+	for(std::size_t i = 0; i < strings.size() && i < info.size() && i < generic_info.size(); ++i)
+	{
+		auto it = std::cbegin(strings[i]);
+		std::size_t count = 0;
+		for(;;)
+		{
+			std::uint32_t cp {};
+			auto const r = LB::utf::read_code_point(it, std::cend(strings[i]), cp);
+			if(!r.second)
+			{
+				break;
+			}
+			it = r.first;
+			expected.push_back(cp);
+			++count;
+		}
+		check(name + " decoded code points " + std::to_string(i), info[i].code_points, count);
+		check(name + " decoded valid units " + std::to_string(i), info[i].valid_units, valid[i]);
+		check(name + " generic code points " + std::to_string(i), generic_info[i].code_points, count);
+		check(name + " generic valid units " + std::to_string(i), generic_info[i].valid_units, valid[i]);
+	}
+	check(name + " decoded size", static_cast<std::size_t>(end - cps.data()), expected.size());
+	check(name + " generic size", generic.size(), expected.size());
+	for(std::size_t i = 0; i < expected.size() && cps.data() + i < end && i < generic.size(); ++i)
+	{
+		check(name + " decoded " + std::to_string(i), cps[i], expected[i]);
+		check(name + " generic " + std::to_string(i), generic[i], expected[i]);
+	}
+}
+
+int main()
+{
+	std::string const ascii (300, 'a');
+	run_tests<char>("UTF-8",
+	{
+		"",
+		"abc",
+		"h\xC3\xA9llo",
+		"\xC3",           //truncated
+		"",
+		ascii,
+		"\xE6\x97\xA5\xE6\x9C\xAC",
+		"a\x80" "b",      //unexpected continuation
+		"x",
+		ascii + "\xF0\x9F\x98\x80" + ascii,
+		"y",
+	});
+	run_tests<char>("UTF-8 ASCII only", {"a", "bc", "", ascii});
+	run_tests<char>("UTF-8 empty", {});
+
+	std::u16string wide;
+	for(std::uint32_t const cp : {0x41u, 0x3A9u, 0x10FFFFu})
+	{
+		wide += LB::utf::encode_code_point<char16_t>(cp);
+	}
+	run_tests<char16_t>("16-bit", {u"", wide, std::u16string(1, u'\x8000'), u"abc"});
+
+	//no offsets at all is not even an empty column
+	std::vector<std::size_t> none;
+	std::string const data = "abc";
+	std::vector<std::int32_t> const offsets;
+	check("no offsets", LB::utf::validate_batch(data.data(), std::cbegin(offsets), std::cend(offsets), std::back_inserter(none)), 0);
+	check("no offsets output", none.size(), 0);
+
+	return result;
+}
@@ -0,0 +1,94 @@
+#include "compact_string.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::size_t width, bool ok)
+{
+	if(!ok)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " with width " << width << std::endl;
+	}
+}
+
+void run_tests(std::vector<std::uint64_t> const &cps, std::size_t const width)
+{
+	std::string utf8;
+	std::u16string utf16;
+	for(auto const cp : cps)
+	{
+		utf8 += LB::utf::encode_code_point<char>(cp);
+		utf16 += LB::utf::encode_code_point<char16_t>(cp);
+	}
+	LB::utf::compact_string const str (std::cbegin(utf8), std::cend(utf8));
+	check("width", width, str.width() == width);
+	check("size", width, str.size() == cps.size() && str.empty() == cps.empty());
+	bool same = true;
+	for(std::size_t i = 0; i < cps.size(); ++i)
+	{
+		same = same && str[i] == cps[i] && str.at(i) == cps[i];
+	}
+	check("indexing", width, same);
+	check("encode", width, str.encode() == utf8);
+	check("encode 16-bit", width, str.encode<char16_t>() == utf16);
+	std::string out;
+	str.encode<char>(std::back_inserter(out));
+	check("encode output iterator", width, out == utf8);
+
+	std::list<char16_t> const list (std::cbegin(utf16), std::cend(utf16));
+	LB::utf::compact_string const other (std::cbegin(list), std::cend(list));
+	check("from other code units", width, other == str && other.width() == width);
+	bool threw = false;
+	try
+	{
+		str.at(cps.size());
+	}
+	catch(std::out_of_range const &)
+	{
+		threw = true;
+	}
+	check("at out of range", width, threw);
+}
+
+int main()
+{
+	//long runs of ASCII around the code point that decides the width
+	std::vector<std::uint64_t> cps;
+	for(int i = 0; i < 200; ++i)
+	{
+		cps.push_back('a' + i%26);
+	}
+	run_tests({}, 1);
+	run_tests(cps, 1);
+	for(std::uint64_t const big : {std::uint64_t{0xE9}, std::uint64_t{0x3A9}, std::uint64_t{0x1F600}, std::uint64_t{1} << 40})
+	{
+		auto mixed = cps;
+		mixed[100] = big;
+		mixed.push_back(big - 1);
+		mixed.push_back('z');
+		run_tests(mixed, (big <= 0xFF)? 1 : (big <= 0xFFFF)? 2 : (big <= 0xFFFFFFFF)? 4 : 8);
+	}
+
+	std::string const invalid = "ab\xC3";
+	bool threw = false;
+	try
+	{
+		LB::utf::compact_string const str (std::cbegin(invalid), std::cend(invalid));
+	}
+	catch(std::invalid_argument const &)
+	{
+		threw = true;
+	}
+	check("invalid throws", 0, threw);
+
+	return result;
+}
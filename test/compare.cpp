@@ -0,0 +1,150 @@
+#include "compare.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, long long output, long long expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+auto sign(int const c)
+-> int
+{
+	return (c > 0) - (c < 0);
+}
+
+template<typename code_unit_t>
+auto encode(std::vector<std::uintmax_t> const &cps)
+-> std::basic_string<code_unit_t>
+{
+	std::basic_string<code_unit_t> str;
+	for(auto const cp : cps)
+	{
+		LB::utf::encode_code_point<code_unit_t>(cp, std::back_inserter(str));
+	}
+	return str;
+}
+
+//every pair of widths and iterator kinds must give the same results
+template<typename code_unit1_t, typename code_unit2_t>
+void run_tests(std::vector<std::uintmax_t> const &a, std::vector<std::uintmax_t> const &b)
+{
+	auto const s1 = encode<code_unit1_t>(a);
+	auto const s2 = encode<code_unit2_t>(b);
+	std::list<code_unit2_t> const l2 (std::cbegin(s2), std::cend(s2));
+	int const expected = (a < b)? -1 : (b < a)? 1 : 0;
+
+	check("compare", sign(LB::utf::compare(std::cbegin(s1), std::cend(s1), std::cbegin(s2), std::cend(s2))), expected);
+	check("compare reversed", sign(LB::utf::compare(std::cbegin(s2), std::cend(s2), std::cbegin(s1), std::cend(s1))), -expected);
+	check("compare list", sign(LB::utf::compare(std::cbegin(s1), std::cend(s1), std::cbegin(l2), std::cend(l2))), expected);
+	check("equal", LB::utf::equal(std::cbegin(s1), std::cend(s1), std::cbegin(s2), std::cend(s2)), a == b);
+	check("hash", LB::utf::hash(std::cbegin(s1), std::cend(s1)) == LB::utf::hash(std::cbegin(l2), std::cend(l2)), a == b);
+
+	auto const same = encode<code_unit1_t>(b);
+	std::list<code_unit1_t> const l1 (std::cbegin(s1), std::cend(s1)), same_list (std::cbegin(same), std::cend(same));
+	check("compare_code_point_order", sign(LB::utf::compare_code_point_order(std::cbegin(s1), std::cend(s1), std::cbegin(same), std::cend(same))), expected);
+	check("compare_code_point_order list", sign(LB::utf::compare_code_point_order(std::cbegin(l1), std::cend(l1), std::cbegin(same_list), std::cend(same_list))), expected);
+}
+
+//random code units, mostly valid, with overlong and invalid sequences mixed in
+template<typename code_unit_t>
+auto random_units(std::mt19937 &gen, std::size_t const n)
+-> std::basic_string<code_unit_t>
+{
+	std::basic_string<code_unit_t> str;
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		switch(gen() % 6)
+		{
+			case 0: case 1: str += static_cast<code_unit_t>('a' + gen() % 3); break;
+			case 2: LB::utf::encode_code_point<code_unit_t>(std::uintmax_t{gen()} >> (gen() % 32), std::back_inserter(str)); break;
+			//an overlong sequence, longer than the code point needs
+			case 3:
+			{
+				using unsigned_t = std::make_unsigned_t<code_unit_t>;
+				str += static_cast<code_unit_t>(~(~unsigned_t{} >> 2));
+				str += static_cast<code_unit_t>((unsigned_t{1} << (sizeof(unsigned_t)*8 - 1)) + gen() % 3);
+				break;
+			}
+			default: str += static_cast<code_unit_t>(gen()); break;
+		}
+	}
+	return str;
+}
+
+//compare_code_point_order must agree with compare whatever the input
+template<typename code_unit_t>
+void run_random()
+{
+	std::mt19937 gen {48};
+	for(int round = 0; round < 20000; ++round)
+	{
+		auto const prefix = random_units<code_unit_t>(gen, gen() % 4);
+		auto const a = prefix + random_units<code_unit_t>(gen, gen() % 3);
+		auto const b = prefix + random_units<code_unit_t>(gen, gen() % 3);
+		int const expected = sign(LB::utf::compare(std::cbegin(a), std::cend(a), std::cbegin(b), std::cend(b)));
+		check("random compare_code_point_order", sign(LB::utf::compare_code_point_order(std::cbegin(a), std::cend(a), std::cbegin(b), std::cend(b))), expected);
+		std::list<code_unit_t> const l1 (std::cbegin(a), std::cend(a)), l2 (std::cbegin(b), std::cend(b));
+		check("random compare_code_point_order list", sign(LB::utf::compare_code_point_order(std::cbegin(l1), std::cend(l1), std::cbegin(l2), std::cend(l2))), expected);
+	}
+}
+
+template<typename code_unit1_t, typename code_unit2_t>
+void run_all()
+{
+	std::vector<std::uintmax_t> const ascii (100, 'a');
+	auto longer = ascii;
+	longer.push_back('b');
+	auto accented = ascii;
+	accented[70] = 0xE9;
+	auto big = ascii;
+	big[30] = std::uintmax_t{1} << 41;
+	auto bigger = big;
+	bigger[30] <<= 1;
+	std::vector<std::vector<std::uintmax_t>> const all {{}, {'a'}, ascii, longer, accented, big, bigger, {0x10FFFF, 'z'}, {0x80}, {0x7F, 0x7F}};
+	for(auto const &a : all)
+	{
+		for(auto const &b : all)
+		{
+			run_tests<code_unit1_t, code_unit2_t>(a, b);
+		}
+	}
+}
+
+int main()
+{
+	run_all<char, char>();
+	run_all<char, char16_t>();
+	run_all<char, char32_t>();
+	run_all<char16_t, char32_t>();
+	run_all<std::uint64_t, char>();
+
+	run_random<char>();
+	run_random<char16_t>();
+	run_random<std::uint64_t>();
+
+	//an invalid sequence only equals the same code unit value, and orders after every code point
+	std::string const invalid = "a\x80" "b";
+	std::u32string const same = U"a\x80" U"b";
+	std::u16string const invalid16 = u"a\x8000";
+	check("invalid equals itself", LB::utf::equal(std::cbegin(invalid), std::cend(invalid), std::cbegin(invalid), std::cend(invalid)), true);
+	check("invalid is not a code point", LB::utf::equal(std::cbegin(invalid), std::cend(invalid), std::cbegin(same), std::cend(same)), false);
+	check("invalid orders last", sign(LB::utf::compare(std::cbegin(invalid), std::cend(invalid), std::cbegin(same), std::cend(same))), 1);
+	check("invalid hash", LB::utf::hash(std::cbegin(invalid), std::cend(invalid)) == LB::utf::hash(std::cbegin(same), std::cend(same)), false);
+	check("invalid in other widths", LB::utf::equal(std::cbegin(invalid), std::cend(invalid), std::cbegin(invalid16), std::cend(invalid16)), false);
+
+	return result;
+}
@@ -0,0 +1,74 @@
+#include "utf.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int result = EXIT_SUCCESS;
+
+template<typename code_unit_t, std::size_t N>
+void validate(char const *what, std::array<code_unit_t, N> const &output, std::basic_string<code_unit_t> const &expected)
+{
+	if(std::basic_string<code_unit_t>(output.begin(), output.end()) != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << std::endl;
+	}
+}
+
+template<typename code_unit_t, std::uintmax_t cp>
+void run_tests()
+{
+	static constexpr auto units = LB::utf::encode_code_point_array<code_unit_t, cp>();
+	validate("encode_code_point_array", units, LB::utf::encode_code_point<code_unit_t>(cp));
+
+	constexpr auto decoded = LB::utf::decode_code_points<1, std::uintmax_t>(&units[0], &units[0] + units.size());
+	static_assert(std::get<0>(decoded) == cp, "decode_code_points");
+}
+
+constexpr char utf8[] = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+static_assert(LB::utf::num_code_units(utf8, utf8 + 1) == 1, "num_code_units ASCII");
+static_assert(LB::utf::num_code_units(utf8 + 1, utf8 + 3, true) == 2, "num_code_units 2 code units");
+static_assert(LB::utf::num_code_units(utf8 + 7, utf8 + 10, true) == 0, "num_code_units truncated");
+static_assert(LB::utf::num_code_units(utf8 + 2, utf8 + 3) == 0, "num_code_units continuation");
+
+constexpr auto read_euro()
+-> std::pair<std::uint32_t, std::size_t>
+{
+	std::uint32_t cp {};
+	auto const r = LB::utf::read_code_point(utf8 + 3, utf8 + 10, cp);
+	return {cp, r.second};
+}
+static_assert(read_euro().first == 0x20AC && read_euro().second == 3, "read_code_point");
+
+constexpr auto pile_of_poo = LB::utf::encode_code_point_array<char, 0x1F4A9>();
+static_assert(static_cast<unsigned char>(pile_of_poo[0]) == 0xF0, "encode_code_point_array header");
+static_assert(static_cast<unsigned char>(pile_of_poo[3]) == 0xA9, "encode_code_point_array payload");
+static_assert(LB::utf::encode_code_point_array<char, std::uintmax_t{1} << 40>().size() == 9, "encode_code_point_array overflowed header");
+
+#if defined(__GNUC__)
+using namespace LB::utf::literals;
+constexpr auto literal = u8"aé€\U0001F600"_cp;
+static_assert(literal.size() == 4, "_cp size");
+static_assert(literal[0] == U'a' && literal[1] == 0xE9 && literal[2] == 0x20AC && literal[3] == 0x1F600, "_cp contents");
+static_assert(""_cp.size() == 0, "_cp empty");
+#endif
+
+int main()
+{
+	run_tests<char, 0>();
+	run_tests<char, 0x7F>();
+	run_tests<char, 0x80>();
+	run_tests<char, 0x10FFFF>();
+	run_tests<char, 0x7FFFFFFF>();
+	run_tests<char, std::uintmax_t{1} << 40>();
+	run_tests<char, ~std::uintmax_t{0}>();
+	run_tests<std::int16_t, 0x8000>();
+	run_tests<std::int16_t, ~std::uintmax_t{0}>();
+	run_tests<std::int32_t, 0xFFFFFFFF>();
+	run_tests<std::int64_t, ~std::uintmax_t{0}>();
+
+	return result;
+}
@@ -0,0 +1,96 @@
+#include "find.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::ptrdiff_t output, std::ptrdiff_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+template<typename container_t>
+void run_tests(container_t const &haystack, std::size_t const big_position)
+{
+	auto const first = std::cbegin(haystack);
+	auto const last = std::cend(haystack);
+	auto const pos = [&](decltype(first) it)
+	{
+		return static_cast<std::ptrdiff_t>(std::distance(first, it));
+	};
+	auto const npos = pos(last);
+
+	check("ASCII", pos(LB::utf::find(first, last, std::uint32_t{'b'})), 1);
+	check("2 code units", pos(LB::utf::find(first, last, std::uint32_t{0xE9})), 3);
+	check("missing", pos(LB::utf::find(first, last, std::uint32_t{0xEA})), npos);
+	//the truncated sequence at the end starts with the same code units as this one
+	check("overflowed header", pos(LB::utf::find(first, last, std::uintmax_t{1} << 41)), static_cast<std::ptrdiff_t>(big_position));
+	check("overflowed header prefix", pos(LB::utf::find(first, last, std::uintmax_t{1} << 40)), npos);
+
+	auto const needle = LB::utf::encode_code_point<char>(0xE9u) + "c";
+	check("substring", pos(LB::utf::find(first, last, std::cbegin(needle), std::cend(needle))), 3);
+	std::list<char> const needle_list (std::cbegin(needle), std::cend(needle));
+	check("non-contiguous substring", pos(LB::utf::find(first, last, std::cbegin(needle_list), std::cend(needle_list))), 3);
+	std::string const partial = "\xCE";
+	check("substring ending inside a sequence", pos(LB::utf::find(first, last, std::cbegin(partial), std::cend(partial))), npos);
+	std::string const continuation = "\xA9";
+	check("substring starting inside a sequence", pos(LB::utf::find(first, last, std::cbegin(continuation), std::cend(continuation))), npos);
+
+	std::vector<std::uint32_t> const set {0x3A9, 'c', 0xE9};
+	check("find_any_of", pos(LB::utf::find_any_of(first, last, std::cbegin(set), std::cend(set))), 2);
+	std::vector<std::uintmax_t> const big_set {std::uintmax_t{1} << 40, std::uintmax_t{1} << 41};
+	check("find_any_of overflowed header", pos(LB::utf::find_any_of(first, last, std::cbegin(big_set), std::cend(big_set))), static_cast<std::ptrdiff_t>(big_position));
+	std::vector<std::uint32_t> const none {0x10FFFF};
+	check("find_any_of missing", pos(LB::utf::find_any_of(first, last, std::cbegin(none), std::cend(none))), npos);
+}
+
+int main()
+{
+	//"a", "b", "c", U+E9, "c", U+3A9, then an overflowed sequence and a truncated one
+	std::string str = "abc";
+	str += LB::utf::encode_code_point<char>(0xE9u);
+	str += "c";
+	str += LB::utf::encode_code_point<char>(0x3A9u);
+	std::size_t const big_position = str.size();
+	std::string const big = LB::utf::encode_code_point<char>(std::uintmax_t{1} << 41);
+	str += big;
+	str += LB::utf::encode_code_point<char>(std::uintmax_t{1} << 40).substr(0, 2); //truncated, so never a match
+	str += std::string(100, 'x');
+
+	std::cout << "Contiguous" << std::endl;
+	run_tests(str, big_position);
+	std::cout << "Non-contiguous" << std::endl;
+	run_tests(std::list<char>(std::cbegin(str), std::cend(str)), big_position);
+
+	//an empty haystack is never dereferenced
+	std::cout << "Empty" << std::endl;
+	{
+		std::vector<char> const empty;
+		check("empty find", std::distance(std::cbegin(empty), LB::utf::find(std::cbegin(empty), std::cend(empty), std::uint32_t{'a'})), 0);
+		check("empty substring", std::distance(std::cbegin(empty), LB::utf::find(std::cbegin(empty), std::cend(empty), std::cbegin(str), std::cend(str))), 0);
+		std::vector<std::uint32_t> const set {'a', 0xE9};
+		check("empty find_any_of", std::distance(std::cbegin(empty), LB::utf::find_any_of(std::cbegin(empty), std::cend(empty), std::cbegin(set), std::cend(set))), 0);
+	}
+
+	//code points of any width are encoded for the code units being searched
+	std::cout << "Wide" << std::endl;
+	{
+		std::u16string utf16 = u"ab";
+		utf16 += LB::utf::encode_code_point<char16_t>(0xE9u);
+		utf16 += LB::utf::encode_code_point<char16_t>(0x1F600u);
+		utf16 += u"c";
+		check("16-bit", LB::utf::find(std::cbegin(utf16), std::cend(utf16), char32_t{0x1F600}) - std::cbegin(utf16), 3);
+		check("16-bit missing", LB::utf::find(std::cbegin(utf16), std::cend(utf16), std::uintmax_t{0x1F601}) - std::cbegin(utf16), static_cast<std::ptrdiff_t>(utf16.size()));
+	}
+
+	return result;
+}
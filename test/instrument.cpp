@@ -0,0 +1,180 @@
+#include "instrument.hpp"
+#include "simd.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+struct recorder final
+{
+	std::vector<std::size_t> sequences;
+	std::vector<LB::utf::error_kind> errors;
+	std::size_t overflows = 0
+	,           fallbacks = 0;
+
+	void on_sequence(std::size_t n) noexcept
+	{
+		sequences.push_back(n);
+	}
+	void on_error(LB::utf::error_kind kind) noexcept
+	{
+		errors.push_back(kind);
+	}
+	void on_header_overflow(std::size_t) noexcept
+	{
+		++overflows;
+	}
+	void on_fallback() noexcept
+	{
+		++fallbacks;
+	}
+};
+
+template<typename instrumentation_t>
+void decode_all(std::string const &str, instrumentation_t &&instrument)
+{
+	for(auto it = std::cbegin(str), end = std::cend(str); it != end; )
+	{
+		std::uintmax_t cp {};
+		auto const r = LB::utf::read_code_point(it, end, cp, instrument);
+		if(r.second)
+		{
+			it = r.first;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+int main()
+{
+	static_assert(noexcept(LB::utf::num_code_units(std::declval<char const *>(), std::declval<char const *>())), "no_instrumentation must not affect noexcept");
+
+	std::string const big = LB::utf::encode_code_point<char>(std::uintmax_t{1} << 40);
+	std::string str = "a";
+	str += LB::utf::encode_code_point<char>(0x10FFFFu);
+	str += big;
+	str += "\x80";                      //unexpected continuation
+	str += big.substr(0, 1) + "a";      //header should have overflowed into a continuation
+	str += "\xC3";                      //truncated at the very end
+
+	std::cout << "Custom policy" << std::endl;
+	{
+		recorder r;
+		decode_all(str, r);
+		check("sequences", r.sequences.size(), 4);
+		check("4 unit sequences", r.sequences.size() > 1? r.sequences[1] : 0, 4);
+		check("overflowed sequence length", r.sequences.size() > 2? r.sequences[2] : 0, big.size());
+		check("errors", r.errors.size(), 3);
+		check("unexpected continuation", r.errors.size() > 0 && r.errors[0] == LB::utf::error_kind::unexpected_continuation, 1);
+		check("not continuation", r.errors.size() > 1 && r.errors[1] == LB::utf::error_kind::not_continuation, 1);
+		check("truncated", r.errors.size() > 2 && r.errors[2] == LB::utf::error_kind::truncated, 1);
+		check("header overflows", r.overflows, 1);
+
+		recorder v;
+		LB::utf::validate(std::cbegin(str), std::cend(str), v);
+		//three non-ASCII sequences, two of which (the overflowed header and the continuation) also miss the unchecked path
+		check("validate fallbacks", v.fallbacks, 5);
+		check("validate errors", v.errors.size(), 1);
+	}
+
+	std::cout << "Too long" << std::endl;
+	{
+		//a header that keeps going is rejected once it outgrows the code point type, before the header is fully read
+		std::string const hostile = "\xFF" + std::string(4096, '\xBF');
+		recorder r;
+		std::uint32_t cp {};
+		check("hostile", LB::utf::read_code_point(std::cbegin(hostile), std::cend(hostile), cp, r).second, 0);
+		check("hostile error", r.errors.size() == 1 && r.errors[0] == LB::utf::error_kind::too_long, 1);
+		check("hostile header overflows", r.overflows, 0);
+
+		std::string const wide = LB::utf::encode_code_point<char>(std::uintmax_t{1} << 40);
+		check("too many units", LB::utf::read_code_point(std::cbegin(wide), std::cend(wide), cp, recorder{}).second, 0);
+		std::uintmax_t big_cp {};
+		check("wide into uintmax_t", LB::utf::read_code_point(std::cbegin(wide), std::cend(wide), big_cp).second, wide.size());
+
+		//same length as the largest 32-bit value, but one more bit
+		std::string const max32 = LB::utf::encode_code_point<char>(0xFFFFFFFFu);
+		std::string const over32 = LB::utf::encode_code_point<char>(std::uintmax_t{1} << 32);
+		check("same length", over32.size(), max32.size());
+		check("max 32-bit", LB::utf::read_code_point(std::cbegin(max32), std::cend(max32), cp).second, max32.size());
+		check("max 32-bit value", cp, 0xFFFFFFFFu);
+		recorder o;
+		check("over 32-bit", LB::utf::read_code_point(std::cbegin(over32), std::cend(over32), cp, o).second, 0);
+		check("over 32-bit error", o.errors.size() == 1 && o.errors[0] == LB::utf::error_kind::too_long, 1);
+
+		std::string const four = LB::utf::encode_code_point<char>(0x10FFFFu);
+		check("within max_units", LB::utf::num_code_units(std::cbegin(four), std::cend(four), true, recorder{}, 4), 4);
+		recorder m;
+		check("beyond max_units", LB::utf::num_code_units(std::cbegin(four), std::cend(four), true, m, 3), 0);
+		check("beyond max_units error", m.errors.size() == 1 && m.errors[0] == LB::utf::error_kind::too_long, 1);
+		check("hostile max_units", LB::utf::num_code_units(std::cbegin(hostile), std::cend(hostile), true, recorder{}, 6), 0);
+
+		LB::utf::thread_local_counters::reset();
+		LB::utf::read_code_point(std::cbegin(hostile), std::cend(hostile), cp, LB::utf::thread_local_counters{});
+		check("too long counted", LB::utf::thread_local_counters::snapshot().errors_of(LB::utf::error_kind::too_long), 1);
+	}
+
+	std::cout << "Thread local counters" << std::endl;
+	{
+		LB::utf::thread_local_counters::reset();
+		decode_all(str, LB::utf::thread_local_counters{});
+		std::thread t {[&]
+		{
+			decode_all(str, LB::utf::thread_local_counters{});
+		}};
+		t.join();
+		auto const c = LB::utf::thread_local_counters::snapshot();
+		check("1 unit sequences", c.sequences_by_length[1], 2*2);
+		check("4 unit sequences", c.sequences_by_length[4], 2);
+		check("overflowed sequences", c.sequences_by_length[big.size()], 2);
+		check("truncated", c.errors_of(LB::utf::error_kind::truncated), 2);
+		check("header overflows", c.header_overflows, 2);
+		LB::utf::thread_local_counters::reset();
+		check("reset", LB::utf::thread_local_counters::snapshot().sequences_by_length[1], 0);
+
+		//a thread which counted before the reset only adds what it counted after it, including once it has exited
+		std::mutex m;
+		std::condition_variable cv;
+		int stage = 0;
+		std::thread u {[&]
+		{
+			decode_all(str, LB::utf::thread_local_counters{});
+			std::unique_lock<std::mutex> lock {m};
+			stage = 1;
+			cv.notify_all();
+			cv.wait(lock, [&]{ return stage == 2; });
+			decode_all(str, LB::utf::thread_local_counters{});
+		}};
+		{
+			std::unique_lock<std::mutex> lock {m};
+			cv.wait(lock, [&]{ return stage == 1; });
+			LB::utf::thread_local_counters::reset();
+			check("reset with a live thread", LB::utf::thread_local_counters::snapshot().sequences_by_length[1], 0);
+			stage = 2;
+			cv.notify_all();
+		}
+		u.join();
+		check("counted after reset", LB::utf::thread_local_counters::snapshot().sequences_by_length[1], 2);
+	}
+
+	return result;
+}
@@ -0,0 +1,141 @@
+#include "json.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <string>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::string const &output, std::string const &expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> \"" << output << "\" != \"" << expected << "\"" << std::endl;
+	}
+}
+
+template<typename container_t>
+auto escape(container_t const &in, LB::utf::escape_options const &options = {})
+-> std::string
+{
+	std::string out;
+	LB::utf::escape_json(std::cbegin(in), std::cend(in), std::back_inserter(out), options);
+	return out;
+}
+
+template<typename container_t>
+auto unescape(container_t const &in, LB::utf::invalid_sequence const invalid = LB::utf::invalid_sequence::replace)
+-> std::string
+{
+	std::string out;
+	LB::utf::unescape_json(std::cbegin(in), std::cend(in), std::back_inserter(out), invalid);
+	return out;
+}
+
+void check_unescape(char const *what, std::string const &in, std::string const &expected, LB::utf::invalid_sequence const invalid = LB::utf::invalid_sequence::replace)
+{
+	check(what, unescape(in, invalid), expected);
+	check(what, unescape(std::list<char>(std::cbegin(in), std::cend(in)), invalid), expected);
+}
+
+//the contiguous and generic paths must agree
+void check_escape(char const *what, std::string const &in, std::string const &expected, LB::utf::escape_options const &options = {})
+{
+	check(what, escape(in, options), expected);
+	check(what, escape(std::list<char>(std::cbegin(in), std::cend(in)), options), expected);
+}
+
+int main()
+{
+	std::string const e9 = LB::utf::encode_code_point<char>(0xE9u);
+	std::string const emoji = LB::utf::encode_code_point<char>(0x1F600u);
+	std::string const big = LB::utf::encode_code_point<char>(std::uintmax_t{1} << 40);
+	std::string const fffd = LB::utf::encode_code_point<char>(0xFFFDu);
+
+	check_escape("clean", "hello world", "hello world");
+	check_escape("short escapes", "\"\\\b\f\n\r\t/", "\\\"\\\\\\b\\f\\n\\r\\t/");
+	check_escape("controls", std::string("a\0b\x1F\x7F", 5), "a\\u0000b\\u001f\x7F");
+	check_escape("non-ASCII passes through", "caf" + e9 + emoji, "caf" + e9 + emoji);
+	check_escape("ASCII only", "caf" + e9 + "\xE2\x82\xAC" + emoji, "caf\\u00e9\\u20ac\\ud83d\\ude00", {true});
+	check_escape("long clean run", std::string(1000, 'x') + "\"" + std::string(1000, 'y'), std::string(1000, 'x') + "\\\"" + std::string(1000, 'y'));
+
+	std::string const invalid = "a\x80" "b\xC3";
+	check_escape("invalid replaced", invalid, "a" + fffd + "b" + fffd);
+	check_escape("invalid replaced ASCII only", invalid, "a\\ufffdb\\ufffd", {true});
+	check_escape("invalid skipped", invalid, "ab", {false, LB::utf::invalid_sequence::skip});
+	check_escape("invalid stops", invalid, "a", {false, LB::utf::invalid_sequence::stop});
+	check_escape("unescapable", "a" + big + "b", "a\\ufffdb", {true});
+	//neither mode writes what is not Unicode
+	check_escape("above U+10FFFF replaced", "a" + big + "b", "a" + fffd + "b");
+	check_escape("above U+10FFFF skipped", "a" + big + "b", "ab", {false, LB::utf::invalid_sequence::skip});
+	check_escape("above U+10FFFF stops", "a" + big + "b", "a", {false, LB::utf::invalid_sequence::stop});
+	std::string const surrogate = LB::utf::encode_code_point<char>(0xD800u);
+	check_escape("surrogate replaced", "a" + surrogate + "b", "a" + fffd + "b");
+	check_escape("surrogate replaced ASCII only", "a" + surrogate + "b", "a\\ufffdb", {true});
+	check_escape("surrogate skipped", "a" + surrogate + "b", "ab", {false, LB::utf::invalid_sequence::skip});
+	{
+		std::string out;
+		auto const r = LB::utf::escape_json(std::cbegin(invalid), std::cend(invalid), std::back_inserter(out), {false, LB::utf::invalid_sequence::stop});
+		check("stop position", std::to_string(r.in - std::cbegin(invalid)), "1");
+	}
+
+	std::u32string const wide = U"tab\there é \U0001F600";
+	check("32-bit code units", escape(wide, {true}), "tab\\there \\u00e9 \\ud83d\\ude00");
+	char buffer[64];
+	char *const end = LB::utf::escape_json(std::cbegin(wide), std::cend(wide), buffer).out;
+	check("pointer output", std::string(buffer, end), "tab\\there " + e9 + " " + emoji);
+
+	check_unescape("clean", "hello world", "hello world");
+	check_unescape("short escapes", "\\\"\\\\\\/\\b\\f\\n\\r\\t", "\"\\/\b\f\n\r\t");
+	check_unescape("u escapes", "caf\\u00e9\\u20AC", "caf" + e9 + "\xE2\x82\xAC");
+	check_unescape("surrogate pair", "\\ud83d\\ude00!", emoji + "!");
+	check_unescape("C-style escape", "\\U0001F600\\UFFFFFFFF", emoji + LB::utf::encode_code_point<char>(0xFFFFFFFFu));
+	check_unescape("raw code units pass through", "caf" + e9 + emoji, "caf" + e9 + emoji);
+	check_unescape("lone high surrogate", "a\\ud83db", "a" + fffd + "b");
+	check_unescape("high surrogate then escape", "\\ud83d\\n", fffd + "\n");
+	check_unescape("lone low surrogate skipped", "a\\ude00b", "ab", LB::utf::invalid_sequence::skip);
+	check_unescape("lone surrogate stops", "a\\ude00b", "a", LB::utf::invalid_sequence::stop);
+	check_unescape("stops at quote", "ab\"cd", "ab");
+	check_unescape("C escapes", "\\a\\v\\'\\?", "\a\v'?");
+	check_unescape("hex escapes", "\\x41\\xe9\\x7z", "A" + e9 + "\az");
+	check_unescape("octal escapes", "\\101\\351\\0\\08\\1234", "A" + e9 + std::string("\0\0" "8" "S" "4", 5));
+	check_unescape("stops at malformed escape", "ab\\q", "ab");
+	check_unescape("stops at empty hex escape", "ab\\xg", "ab");
+	check_unescape("stops at short hex", "ab\\u12", "ab");
+	check_unescape("stops at trailing backslash", "ab\\", "ab");
+	check_unescape("heavy escaping", std::string(500, 'x') + "\\n\\u0041\\t" + std::string(500, 'y'), std::string(500, 'x') + "\nA\t" + std::string(500, 'y'));
+	{
+		std::string const in = "ab\"cd";
+		std::string out;
+		auto const r = LB::utf::unescape_json(std::cbegin(in), std::cend(in), std::back_inserter(out));
+		check("quote position", std::to_string(r.in - std::cbegin(in)), "2");
+	}
+	std::u16string const escaped16 = u"caf\\u00e9 \\ud83d\\ude00";
+	std::u16string wide_out;
+	LB::utf::unescape_json(std::cbegin(escaped16), std::cend(escaped16), std::back_inserter(wide_out));
+	check("16-bit code units", std::to_string(wide_out == u"caf" + LB::utf::encode_code_point<char16_t>(0xE9u) + u" " + LB::utf::encode_code_point<char16_t>(0x1F600u)), "1");
+
+	//escaping then unescaping gives back the original code points
+	std::string original;
+	for(std::uint32_t cp = 0; cp < 0x11000; cp += 13)
+	{
+		if(cp < 0xD800 || cp > 0xDFFF)
+		{
+			original += LB::utf::encode_code_point<char>(cp);
+		}
+	}
+	for(bool const ascii_only : {false, true})
+	{
+		auto const escaped = escape(original, {ascii_only});
+		std::string out;
+		auto const r = LB::utf::unescape_json(escaped.data(), escaped.data() + escaped.size(), std::back_inserter(out), LB::utf::invalid_sequence::stop);
+		check("round trip", out, original);
+		check("round trip reaches the end", std::to_string(r.in - escaped.data()), std::to_string(escaped.size()));
+	}
+
+	return result;
+}
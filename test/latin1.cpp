@@ -0,0 +1,131 @@
+#include "transcode.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//the UTF-8 for Latin-1 text, one character at a time
+auto encode(std::string const &latin1)
+-> std::string
+{
+	std::string utf8;
+	for(char const c : latin1)
+	{
+		LB::utf::encode_code_point<char>(static_cast<unsigned char>(c), std::back_inserter(utf8));
+	}
+	return utf8;
+}
+
+void run_tests(std::string const &what, std::string const &latin1)
+{
+	std::string const expected = encode(latin1);
+	check(what + " latin1_to_utf8_size", LB::utf::latin1_to_utf8_size(std::cbegin(latin1), std::cend(latin1)), expected.size());
+	check(what + " latin1_to_utf8", LB::utf::latin1_to_utf8(std::cbegin(latin1), std::cend(latin1)) == expected, true);
+
+	std::list<char> const list (std::cbegin(latin1), std::cend(latin1));
+	std::string generic;
+	LB::utf::latin1_to_utf8(std::cbegin(list), std::cend(list), std::back_inserter(generic));
+	check(what + " latin1_to_utf8 iterators", generic == expected, true);
+	check(what + " latin1_to_utf8_size iterators", LB::utf::latin1_to_utf8_size(std::cbegin(list), std::cend(list)), expected.size());
+
+	//the pointer output is what the kernels write to, nothing may be written past it
+	std::string back (latin1.size() + 1, '\x01');
+	auto const r = LB::utf::utf8_to_latin1(expected.data(), expected.data() + expected.size(), &back[0]);
+	check(what + " utf8_to_latin1 in", static_cast<std::size_t>(r.in - expected.data()), expected.size());
+	check(what + " utf8_to_latin1 out", static_cast<std::size_t>(r.out - back.data()), latin1.size());
+	check(what + " utf8_to_latin1", back.compare(0, latin1.size(), latin1) == 0 && back.back() == '\x01', true);
+
+	std::list<char> const utf8_list (std::cbegin(expected), std::cend(expected));
+	std::string generic_back;
+	check(what + " utf8_to_latin1 iterators", LB::utf::utf8_to_latin1(std::cbegin(utf8_list), std::cend(utf8_list), std::back_inserter(generic_back)).in == std::cend(utf8_list) && generic_back == latin1, true);
+}
+
+int main()
+{
+	std::cout << "Latin-1 to UTF-8" << std::endl;
+	{
+		std::string all;
+		for(unsigned c = 0; c < 256; ++c)
+		{
+			all += static_cast<char>(c);
+		}
+		run_tests("every character", all);
+		run_tests("empty", "");
+		run_tests("ASCII", std::string(200, 'a'));
+		run_tests("high", std::string(200, '\xE9'));
+
+		//runs of every length, so the vector loops see blocks of each kind and every mix of them
+		std::mt19937 gen {50};
+		for(int round = 0; round < 200; ++round)
+		{
+			std::string latin1;
+			std::size_t const n = gen() % 300;
+			while(latin1.size() < n)
+			{
+				std::size_t const run = 1 + gen() % (round % 2? 100 : 5);
+				bool const high = gen() % 2;
+				for(std::size_t i = 0; i < run && latin1.size() < n; ++i)
+				{
+					latin1 += static_cast<char>(high? 0x80u | gen() : gen() & 0x7Fu);
+				}
+			}
+			run_tests("round " + std::to_string(round), latin1);
+		}
+	}
+
+	std::cout << "UTF-8 to Latin-1" << std::endl;
+	{
+		//stops at the first code point above U+FF, after the ones before it
+		std::string const wide = std::string(100, 'a') + "\xC3\xA9\xE2\x82\xAC" + std::string(100, 'b');
+		std::string out (wide.size(), '\0');
+		auto const r = LB::utf::utf8_to_latin1(wide.data(), wide.data() + wide.size(), &out[0]);
+		check("unrepresentable in", static_cast<std::size_t>(r.in - wide.data()), 102);
+		check("unrepresentable out", static_cast<std::size_t>(r.out - out.data()), 101);
+		check("unrepresentable output", out.compare(0, 101, std::string(100, 'a') + "\xE9") == 0, true);
+
+		//or writes the replacement for it and carries on
+		auto const replaced = LB::utf::utf8_to_latin1(wide.data(), wide.data() + wide.size(), &out[0], '?');
+		check("replaced in", static_cast<std::size_t>(replaced.in - wide.data()), wide.size());
+		check("replaced out", static_cast<std::size_t>(replaced.out - out.data()), 202);
+		check("replaced output", out.compare(0, 202, std::string(100, 'a') + "\xE9?" + std::string(100, 'b')) == 0, true);
+		std::string generic;
+		LB::utf::utf8_to_latin1(std::cbegin(wide), std::cend(wide), std::back_inserter(generic), '?');
+		check("replaced iterators", generic == out.substr(0, 202), true);
+
+		//invalid sequences stop it either way
+		std::string const invalid = std::string(100, 'a') + "\xC3\xA9\x80" + std::string(100, 'b');
+		check("invalid", static_cast<std::size_t>(LB::utf::utf8_to_latin1(invalid.data(), invalid.data() + invalid.size(), &out[0]).in - invalid.data()), 102);
+		check("invalid replaced", static_cast<std::size_t>(LB::utf::utf8_to_latin1(invalid.data(), invalid.data() + invalid.size(), &out[0], '?').in - invalid.data()), 102);
+		std::string const truncated = std::string(100, 'a') + "\xC3";
+		check("truncated", static_cast<std::size_t>(LB::utf::utf8_to_latin1(truncated.data(), truncated.data() + truncated.size(), &out[0]).in - truncated.data()), 100);
+
+		//read_code_point decodes overlong sequences, so they convert like the minimal ones
+		std::string const overlong = std::string(100, 'a') + "\xC1\x81\xE0\x83\xA9";
+		auto const o = LB::utf::utf8_to_latin1(overlong.data(), overlong.data() + overlong.size(), &out[0]);
+		check("overlong in", static_cast<std::size_t>(o.in - overlong.data()), overlong.size());
+		check("overlong output", out.compare(0, 102, std::string(100, 'a') + "A\xE9") == 0, true);
+
+		//any width of code units can be converted, without the kernels
+		std::u16string const utf16 = u"café €";
+		std::string narrow;
+		check("16-bit", LB::utf::utf8_to_latin1(std::cbegin(utf16), std::cend(utf16), std::back_inserter(narrow), '?').in == std::cend(utf16) && narrow == "caf\xE9 ?", true);
+	}
+
+	return result;
+}
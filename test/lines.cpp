@@ -0,0 +1,83 @@
+#include "lines.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::size_t offset, std::size_t output, std::size_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " at " << offset << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//compares every offset against counting from the start of the text
+template<typename code_unit_t>
+void run_tests(std::basic_string<code_unit_t> const &text)
+{
+	LB::utf::basic_line_index<code_unit_t> const index (text.data(), text.data() + text.size());
+	std::size_t line = 0
+	,           column = 0
+	,           start = 0;
+	for(std::size_t offset = 0; offset <= text.size(); ++offset)
+	{
+		bool const lead = offset == text.size() || !LB::utf::detail::is_continuation(text[offset]);
+		auto const pos = index.position(offset);
+		check("line", offset, pos.line, line);
+		check("column", offset, pos.column, column);
+		if(lead)
+		{
+			check("offset", offset, index.offset(pos), offset);
+		}
+		check("line_start", offset, index.line_start(line), start);
+		if(offset == text.size())
+		{
+			break;
+		}
+		column += lead;
+		if(text[offset] == code_unit_t('\n'))
+		{
+			check("line_end", offset, index.line_end(line), offset);
+			check("column past the end", offset, index.offset({line, column + 5}), offset);
+			++line;
+			column = 0;
+			start = offset + 1;
+		}
+	}
+	check("lines", text.size(), index.lines(), line + 1);
+	check("line past the end", text.size(), index.offset({line + 1, 0}), text.size());
+	check("offset past the end", text.size(), index.position(text.size() + 10).line, line);
+}
+
+int main()
+{
+	std::mt19937 gen {37};
+	std::string text;
+	std::u16string wide;
+	for(int i = 0; i < 5000; ++i)
+	{
+		//mostly short lines, with some longer than a checkpoint interval
+		std::uint32_t const r = gen() % 100;
+		std::uint32_t const cp = (r < 3)? '\n' : (r < 70)? 'a' + r%26 : (r < 90)? 0xE0 + r : (r < 99)? 0x1F600 + r : 0x10FFFF;
+		std::size_t const repeat = (gen() % 200 == 0)? 700 : 1;
+		for(std::size_t j = 0; j < repeat; ++j)
+		{
+			text += LB::utf::encode_code_point<char>(cp);
+			wide += LB::utf::encode_code_point<char16_t>(cp);
+		}
+	}
+	run_tests(text);
+	run_tests(wide);
+	run_tests(std::string{});
+	run_tests(std::string{"\n"});
+	run_tests(std::string(1024, 'x'));
+	run_tests(std::string{"\xA9" "ab\n\xA9"});
+
+	return result;
+}
@@ -0,0 +1,80 @@
+#include "parallel.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+template<typename code_unit_t, typename code_point_t>
+void run_tests(std::vector<code_point_t> const &cps)
+{
+	std::basic_string<code_unit_t> serial;
+	for(auto const cp : cps)
+	{
+		LB::utf::encode_code_point<code_unit_t>(cp, std::back_inserter(serial));
+	}
+	for(std::size_t const threads : {0, 1, 2, 3, 8, 64})
+	{
+		if(LB::utf::encode_parallel<code_unit_t>(std::cbegin(cps), std::cend(cps), threads) != serial)
+		{
+			result = EXIT_FAILURE;
+			std::cout << "Fail: " << cps.size() << " code points as " << sizeof(code_unit_t)*8 << "-bit code units with " << threads << " threads" << std::endl;
+		}
+	}
+}
+
+int main()
+{
+	//enough code points for several chunks, with every sequence length
+	std::mt19937_64 gen {40};
+	std::vector<std::uint32_t> cps (500000);
+	std::vector<std::uintmax_t> big (200000);
+	for(auto &cp : cps)
+	{
+		cp = static_cast<std::uint32_t>(gen() >> (gen() % 64)) & 0x7FFFFFFFu;
+	}
+	for(auto &cp : big)
+	{
+		cp = static_cast<std::uintmax_t>(gen() >> (gen() % 64));
+	}
+	run_tests<char>(cps);
+	run_tests<char16_t>(cps);
+	run_tests<char32_t>(cps);
+	run_tests<char>(big);
+	run_tests<char>(std::vector<std::uint32_t>{});
+	run_tests<char>(std::vector<std::uint32_t>(200000, 'a'));
+	run_tests<char>(std::vector<std::uint32_t>(5, 0x10FFFF));
+
+	//an exception on the calling thread is only seen once the threads already started have been joined, rather than terminating
+	std::atomic<int> finished {0};
+	try
+	{
+		LB::utf::detail::run_chunks(4, [&](std::size_t const chunk)
+		{
+			if(chunk == 3)
+			{
+				throw std::runtime_error("chunk failed");
+			}
+			++finished;
+		});
+		result = EXIT_FAILURE;
+		std::cout << "Fail: run_chunks swallowed an exception" << std::endl;
+	}
+	catch(std::runtime_error const &)
+	{
+		if(finished != 3)
+		{
+			result = EXIT_FAILURE;
+			std::cout << "Fail: run_chunks threw before joining, " << finished << " chunks finished" << std::endl;
+		}
+	}
+
+	return result;
+}
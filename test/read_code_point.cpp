@@ -178,6 +178,9 @@ int main()
 			{{0b11111101, _1, _1, _1, _1, _1}, {6, ones(1 + 5*6)}},
 			{{0b11111110, _0, _0, _0, _0, _0, _0}, {7, 0}},
 			{{0b11111110, _1, _1, _1, _1, _1, _1}, {7, ones(1 + 5*7)}},
+			//a header filling the first code unit is still followed by continuations
+			{{0b11111110, 0b11111100, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111110, 0b00111111, _1, _1, _1, _1, _1}, {0, {}}},
 			{{0b11111111, 0b10000000, _0, _0, _0, _0, _0, _0, _0}, {9, 0}},
 			{{0b11111111, 0b10011111, _1, _1, _1, _1, _1, _1, _1}, {9, ones(2 + 5*9)}},
 			{{0b11111111, 0b10100000, _0, _0, _0, _0, _0, _0, _0, _0}, {10, 0}},
@@ -186,23 +189,23 @@ int main()
 			{{0b11111111, 0b10110111, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {11, ones(2 + 5*11)}},
 			{{0b11111111, 0b10111000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {12, 0}},
 			{{0b11111111, 0b10111011, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {12, ones(2 + 5*12)}},
-			//more than 64-bits
+			//more than 64-bits, rejected unless the value still fits in std::uintmax_t
 			{{0b11111111, 0b10111100, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {13, 0}},
-			{{0b11111111, 0b10111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {13, ones(2 + 5*13)}},
-			{{0b11111111, 0b10111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {14, 0}},
-			{{0b11111111, 0b10111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {14, ones(2 + 5*14)}},
-			{{0b11111111, 0b10111111, 0b10000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {16, 0}},
-			{{0b11111111, 0b10111111, 0b10011111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {16, ones(3 + 5*16)}},
-			{{0b11111111, 0b10111111, 0b10100000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {17, 0}},
-			{{0b11111111, 0b10111111, 0b10101111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {17, ones(3 + 5*17)}},
-			{{0b11111111, 0b10111111, 0b10110000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {18, 0}},
-			{{0b11111111, 0b10111111, 0b10110111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {18, ones(3 + 5*18)}},
-			{{0b11111111, 0b10111111, 0b10111000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {19, 0}},
-			{{0b11111111, 0b10111111, 0b10111011, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {19, ones(3 + 5*19)}},
-			{{0b11111111, 0b10111111, 0b10111100, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {20, 0}},
-			{{0b11111111, 0b10111111, 0b10111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {20, ones(3 + 5*20)}},
-			{{0b11111111, 0b10111111, 0b10111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {21, 0}},
-			{{0b11111111, 0b10111111, 0b10111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {21, ones(3 + 5*21)}},
+			{{0b11111111, 0b10111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10011111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10100000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10101111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10110000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10110111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111011, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111100, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111, 0b10111111, 0b10111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
 		});
 	}
 	{
@@ -220,39 +223,39 @@ int main()
 			{{0b11101111'11111111, _1, _1}, {3, ones(1 + 13*3)}},
 			{{0b11110000'00000000, _0, _0, _0}, {4, 0}},
 			{{0b11110111'11111111, _1, _1, _1}, {4, ones(1 + 13*4)}},
-			//more than 64-bits
+			//more than 64-bits, rejected unless the value still fits in std::uintmax_t
 			{{0b11111000'00000000, _0, _0, _0, _0}, {5, 0}},
-			{{0b11111011'11111111, _1, _1, _1, _1}, {5, ones(1 + 13*5)}},
-			{{0b11111100'00000000, _0, _0, _0, _0, _0}, {6, 0}},
-			{{0b11111101'11111111, _1, _1, _1, _1, _1}, {6, ones(1 + 13*6)}},
-			{{0b11111110'00000000, _0, _0, _0, _0, _0, _0}, {7, 0}},
-			{{0b11111110'11111111, _1, _1, _1, _1, _1, _1}, {7, ones(1 + 13*7)}},
-			{{0b11111111'00000000, _0, _0, _0, _0, _0, _0, _0}, {8, 0}},
-			{{0b11111111'01111111, _1, _1, _1, _1, _1, _1, _1}, {8, ones(1 + 13*8)}},
-			{{0b11111111'10000000, _0, _0, _0, _0, _0, _0, _0, _0}, {9, 0}},
-			{{0b11111111'10111111, _1, _1, _1, _1, _1, _1, _1, _1}, {9, ones(1 + 13*9)}},
-			{{0b11111111'11000000, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {10, 0}},
-			{{0b11111111'11011111, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {10, ones(1 + 13*10)}},
-			{{0b11111111'11100000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {11, 0}},
-			{{0b11111111'11101111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {11, ones(1 + 13*11)}},
-			{{0b11111111'11110000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {12, 0}},
-			{{0b11111111'11110111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {12, ones(1 + 13*12)}},
-			{{0b11111111'11111000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {13, 0}},
-			{{0b11111111'11111011, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {13, ones(1 + 13*13)}},
-			{{0b11111111'11111100, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {14, 0}},
-			{{0b11111111'11111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {14, ones(1 + 13*14)}},
-			{{0b11111111'11111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {15, 0}},
-			{{0b11111111'11111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {15, ones(1 + 13*15)}},
-			{{0b11111111'11111111, 0b10000000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {17, 0}},
-			{{0b11111111'11111111, 0b10011111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {17, ones(2 + 13*17)}},
-			{{0b11111111'11111111, 0b10100000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {18, 0}},
-			{{0b11111111'11111111, 0b10101111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {18, ones(2 + 13*18)}},
-			{{0b11111111'11111111, 0b10110000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {19, 0}},
-			{{0b11111111'11111111, 0b10110111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {19, ones(2 + 13*19)}},
-			{{0b11111111'11111111, 0b10111000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {20, 0}},
-			{{0b11111111'11111111, 0b10111011'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {20, ones(2 + 13*20)}},
-			{{0b11111111'11111111, 0b10111100'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {21, 0}},
-			{{0b11111111'11111111, 0b10111101'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {21, ones(2 + 13*21)}},
+			{{0b11111011'11111111, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111100'00000000, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111101'11111111, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111110'00000000, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111110'11111111, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'00000000, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'01111111, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'10000000, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'10111111, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11000000, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11011111, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11100000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11101111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11110000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11110111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111011, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111100, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111101, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111110, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111110, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111111, 0b10000000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111111, 0b10011111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111111, 0b10100000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111111, 0b10101111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111111, 0b10110000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111111, 0b10110111'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111111, 0b10111000'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111111, 0b10111011'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
+			{{0b11111111'11111111, 0b10111100'00000000, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0, _0}, {0, {}}},
+			{{0b11111111'11111111, 0b10111101'11111111, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1, _1}, {0, {}}},
 		});
 	}
 
@@ -0,0 +1,145 @@
+#include "simd.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//counts the sequences validation had to look at one at a time
+struct counting final
+{
+	std::size_t fallbacks = 0;
+
+	constexpr void on_sequence(std::size_t) const noexcept
+	{
+	}
+	constexpr void on_error(LB::utf::error_kind) const noexcept
+	{
+	}
+	constexpr void on_header_overflow(std::size_t) const noexcept
+	{
+	}
+	void on_fallback() noexcept
+	{
+		++fallbacks;
+	}
+};
+
+auto random_text(std::mt19937 &gen, std::size_t const n)
+-> std::string
+{
+	std::string str;
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		switch(gen() % 4)
+		{
+			case 0: str += static_cast<char>('a' + gen() % 26); break;
+			case 1: str += LB::utf::encode_code_point<char>(0x80u + gen() % 0x800u); break;
+			case 2: str += LB::utf::encode_code_point<char>(0x10000u + gen() % 0x100000u); break;
+			default: str += LB::utf::encode_code_point<char>(std::uintmax_t{gen()} << (gen() % 32)); break;
+		}
+	}
+	return str;
+}
+
+int main()
+{
+	std::mt19937 gen {45};
+	for(int round = 0; round < 2000; ++round)
+	{
+		std::string str = random_text(gen, 1 + gen() % 40);
+		std::size_t const at = gen() % (str.size() + 1);
+		std::size_t const removed = gen() % 3 == 0? gen() % (str.size() - at + 1) : 0;
+		std::string inserted;
+		switch(gen() % 4)
+		{
+			case 0: break;
+			case 1: inserted = random_text(gen, gen() % 4); break;
+			case 2: inserted = std::string(1, static_cast<char>(0x80u | gen())); break;
+			default: for(std::size_t i = gen() % 4; i; --i) inserted += static_cast<char>(gen()); break;
+		}
+		str.replace(at, removed, inserted);
+
+		std::string const what = "round " + std::to_string(round);
+		auto const full = LB::utf::validate(std::cbegin(str), std::cend(str));
+		auto const edit_first = std::cbegin(str) + static_cast<std::ptrdiff_t>(at);
+		auto const edit_last = edit_first + static_cast<std::ptrdiff_t>(inserted.size());
+		check(what, static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cend(str), edit_first, edit_last) - std::cbegin(str)), static_cast<std::size_t>(full - std::cbegin(str)));
+
+		std::list<char> const list (std::cbegin(str), std::cend(str));
+		auto const list_first = std::next(std::cbegin(list), static_cast<std::ptrdiff_t>(at));
+		auto const list_last = std::next(list_first, static_cast<std::ptrdiff_t>(inserted.size()));
+		check(what + " list", static_cast<std::size_t>(std::distance(std::cbegin(list), LB::utf::revalidate(std::cbegin(list), std::cend(list), list_first, list_last))), static_cast<std::size_t>(full - std::cbegin(str)));
+	}
+
+	std::cout << "Window" << std::endl;
+	{
+		//only the sequences around the edit are read
+		std::string str;
+		for(int i = 0; i < 1000; ++i)
+		{
+			str += "\xC3\xA9";
+		}
+		std::size_t const at = 1001;
+		str.insert(at, "\xE6\x97\xA5");
+		counting c;
+		auto const first = std::cbegin(str) + static_cast<std::ptrdiff_t>(at);
+		check("inserted", static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cend(str), first, first + 3, c) - std::cbegin(str)), 1001 - 1);
+		//the inserted sequence split the one before it
+		check("split sequences", c.fallbacks, 1);
+
+		str.erase(at, 3);
+		str.insert(at - 1, "\xE6\x97\xA5");
+		c = counting{};
+		auto const second = std::cbegin(str) + static_cast<std::ptrdiff_t>(at - 1);
+		check("between", static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cend(str), second, second + 3, c) - std::cbegin(str)), str.size());
+		check("between sequences", c.fallbacks, 2);
+
+		str.erase(at - 1, 4);
+		c = counting{};
+		auto const third = std::cbegin(str) + static_cast<std::ptrdiff_t>(at - 1);
+		//the deletion left the continuation of the next sequence behind
+		check("deleted", static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cend(str), third, third, c) - std::cbegin(str)), at - 1);
+		//the stray continuation also misses the unchecked path
+		check("deleted sequences", c.fallbacks, 3);
+
+		check("empty", static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cbegin(str), std::cbegin(str), std::cbegin(str)) - std::cbegin(str)), 0);
+	}
+
+	std::cout << "Bounded" << std::endl;
+	{
+		//runs of continuations longer than any sequence of std::uintmax_t are validated from the start, with the same result
+		std::string str = std::string(100, 'a') + std::string(200, '\x80') + std::string(100, 'b');
+		auto const full = LB::utf::validate(std::cbegin(str), std::cend(str));
+		for(std::size_t const at : {100, 150, 299, 300})
+		{
+			auto const edit = std::cbegin(str) + static_cast<std::ptrdiff_t>(at);
+			check("continuations at " + std::to_string(at), static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(str), std::cend(str), edit, edit) - std::cbegin(str)), static_cast<std::size_t>(full - std::cbegin(str)));
+		}
+
+		//a sequence too long for std::uintmax_t is still valid, so falling back must not reject it
+		std::string const big = std::string(100, 'a') + "\xFF\xBD" + std::string(11, '\x80') + std::string(100, 'b');
+		check("too long for std::uintmax_t is valid", static_cast<std::size_t>(LB::utf::validate(std::cbegin(big), std::cend(big)) - std::cbegin(big)), big.size());
+		for(std::size_t const at : {102, 107, 113})
+		{
+			auto const edit = std::cbegin(big) + static_cast<std::ptrdiff_t>(at);
+			check("too long for std::uintmax_t at " + std::to_string(at), static_cast<std::size_t>(LB::utf::revalidate(std::cbegin(big), std::cend(big), edit, edit) - std::cbegin(big)), big.size());
+		}
+	}
+
+	return result;
+}
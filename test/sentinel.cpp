@@ -0,0 +1,140 @@
+#include "simd.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <string>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//a sentinel of another kind, reached at a newline
+struct newline final
+{
+};
+template<typename code_unit_iterator>
+auto operator==(code_unit_iterator const &it, newline)
+-> bool
+{
+	return *it == '\n';
+}
+template<typename code_unit_iterator>
+auto operator!=(code_unit_iterator const &it, newline)
+-> bool
+{
+	return *it != '\n';
+}
+
+struct recorder final
+{
+	LB::utf::error_kind last_error {};
+	std::size_t errors = 0;
+
+	constexpr void on_sequence(std::size_t) const noexcept
+	{
+	}
+	void on_error(LB::utf::error_kind const kind) noexcept
+	{
+		last_error = kind;
+		++errors;
+	}
+	constexpr void on_header_overflow(std::size_t) const noexcept
+	{
+	}
+	constexpr void on_fallback() const noexcept
+	{
+	}
+};
+
+int main()
+{
+	using LB::utf::null_sentinel;
+
+	std::cout << "Decoding" << std::endl;
+	{
+		char const *const str = "a\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80";
+		char const *it = str;
+		std::uint32_t cps[4] {};
+		for(auto &cp : cps)
+		{
+			auto const r = LB::utf::read_code_point(it, null_sentinel{}, cp);
+			check("sequence at " + std::to_string(it - str), r.second, static_cast<std::size_t>(r.first - it));
+			it = r.first;
+		}
+		check("first", cps[0], 'a');
+		check("second", cps[1], 0xE9);
+		check("third", cps[2], 0x65E5);
+		check("fourth", cps[3], 0x1F600);
+		check("at the end", *it == 0, true);
+		std::uint32_t cp {};
+		check("end", LB::utf::read_code_point(it, null_sentinel{}, cp).second, 0);
+		check("num_code_units", LB::utf::num_code_units(str + 1, null_sentinel{}), 2);
+		check("num_code_units at the end", LB::utf::num_code_units(it, null_sentinel{}), 0);
+
+		//a sequence cut off by the terminator is truncated, not followed by something else
+		char const *const cut = "\xE6\x97";
+		recorder r;
+		check("cut off", LB::utf::read_code_point(cut, null_sentinel{}, cp, r).second, 0);
+		check("cut off error", r.errors == 1 && r.last_error == LB::utf::error_kind::truncated, true);
+
+		std::u16string const wide = LB::utf::encode_code_point<char16_t>(0x10FFFFu);
+		check("16-bit", LB::utf::read_code_point(wide.c_str(), null_sentinel{}, cp).second, wide.size());
+		check("16-bit value", cp, 0x10FFFF);
+
+		std::string const line = "\xC3\xA9\n";
+		check("other sentinel", LB::utf::read_code_point(std::cbegin(line), newline{}, cp).second, 2);
+		check("other sentinel at the end", LB::utf::num_code_units(std::cbegin(line) + 2, newline{}), 0);
+	}
+
+	std::cout << "Bulk operations" << std::endl;
+	{
+		std::string str;
+		for(std::uint32_t cp = 1; cp < 0x3000; cp += 13)
+		{
+			str += LB::utf::encode_code_point<char>(cp);
+		}
+		//every suffix, so the terminated kernels start at every alignment
+		for(std::size_t i = 0; i < str.size(); i += 7)
+		{
+			char const *const p = str.c_str() + i;
+			check("count_code_points from " + std::to_string(i), LB::utf::count_code_points(p, null_sentinel{}), LB::utf::count_code_points(p, str.data() + str.size()));
+			check("validate from " + std::to_string(i), static_cast<std::size_t>(LB::utf::validate(p, null_sentinel{}) - p), static_cast<std::size_t>(LB::utf::validate(p, str.data() + str.size()) - p));
+		}
+		check("count_code_points empty", LB::utf::count_code_points("", null_sentinel{}), 0);
+		check("validate empty", *LB::utf::validate("", null_sentinel{}) == 0, true);
+
+		std::string const bad = std::string(100, 'a') + "\xC3\xA9\x80" + std::string(100, 'b');
+		check("validate invalid", static_cast<std::size_t>(LB::utf::validate(bad.c_str(), null_sentinel{}) - bad.c_str()), 102);
+		std::string const truncated = std::string(100, 'a') + "\xE6\x97";
+		recorder r;
+		check("validate truncated", static_cast<std::size_t>(LB::utf::validate(truncated.c_str(), null_sentinel{}, r) - truncated.c_str()), 100);
+		check("validate truncated error", r.errors == 1 && r.last_error == LB::utf::error_kind::truncated, true);
+
+		//stops at the first terminator even if more follows
+		char const embedded[] = "ab\0\xC3\xA9";
+		check("embedded count", LB::utf::count_code_points(embedded, null_sentinel{}), 2);
+		check("embedded validate", static_cast<std::size_t>(LB::utf::validate(embedded, null_sentinel{}) - embedded), 2);
+
+		std::list<char> const list (std::cbegin(str), std::cend(str) + 1);
+		check("count_code_points list", LB::utf::count_code_points(std::cbegin(list), null_sentinel{}), LB::utf::count_code_points(std::cbegin(str), std::cend(str)));
+		check("validate list", static_cast<std::size_t>(std::distance(std::cbegin(list), LB::utf::validate(std::cbegin(list), null_sentinel{}))), str.size());
+		std::u32string const wide = U"\x41\x10FFFF";
+		check("count_code_points 32-bit", LB::utf::count_code_points(wide.c_str(), null_sentinel{}), 2);
+
+		std::string const lines = "\xC3\xA9t\xC3\xA9\nhiver";
+		check("count_code_points other sentinel", LB::utf::count_code_points(std::cbegin(lines), newline{}), 3);
+	}
+
+	return result;
+}
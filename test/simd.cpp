@@ -0,0 +1,300 @@
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, char const *name, std::size_t n, std::size_t output, std::size_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " with " << name << " kernels on " << n << " code units -> " << output << " != " << expected << std::endl;
+	}
+}
+
+//the wider kernels must agree with the scalar ones, for code units with every combination of their top two bits
+template<typename code_unit_t>
+void run_wide_tests(LB::utf::simd::kernels const &k, std::size_t (*const single_prefix)(code_unit_t const *, std::size_t), std::size_t (*const count_leads)(code_unit_t const *, std::size_t), char const *const width)
+{
+	std::mt19937_64 gen {49};
+	std::string const what = std::string(" of ") + width;
+	constexpr std::size_t shift = sizeof(code_unit_t)*8 - 2;
+	for(std::size_t n = 0; n < 150; ++n)
+	{
+		for(int round = 0; round < 4; ++round)
+		{
+			//single code units, except in the last round
+			code_unit_t const mask = (round == 3)? static_cast<code_unit_t>(~code_unit_t{}) : static_cast<code_unit_t>(~code_unit_t{} >> 1);
+			std::vector<code_unit_t> v (n);
+			for(auto &cu : v)
+			{
+				cu = static_cast<code_unit_t>(gen()) & mask;
+			}
+			if(round && n)
+			{
+				//plant a lead or continuation with the other bits random
+				v[gen() % n] = static_cast<code_unit_t>((static_cast<code_unit_t>(2 + gen() % 2) << shift) | (gen() & 0x3Fu));
+			}
+			check(("single_prefix" + what).c_str(), k.name, n, single_prefix(v.data(), n), LB::utf::scalar::single_prefix(v.data(), n));
+			check(("count_leads" + what).c_str(), k.name, n, count_leads(v.data(), n), LB::utf::scalar::count_leads_wide(v.data(), n));
+		}
+	}
+	//exercise the accumulator flush in the counting kernels
+	std::vector<code_unit_t> big (600000, static_cast<code_unit_t>(code_unit_t{0b10} << shift));
+	for(std::size_t i = 0; i < big.size(); i += 3)
+	{
+		big[i] = 'a';
+	}
+	check(("count_leads" + what).c_str(), k.name, big.size(), count_leads(big.data(), big.size()), LB::utf::scalar::count_leads_wide(big.data(), big.size()));
+}
+
+//the Latin-1 kernels must agree with the scalar ones on runs of ASCII, of characters from 0x80 and of other sequences,
+//and write nothing past the output they return
+void run_latin1_tests(LB::utf::simd::kernels const &k)
+{
+	std::mt19937 gen {44};
+	for(std::size_t n = 0; n < 400; n += 1 + n/40)
+	{
+		for(int round = 0; round < 8; ++round)
+		{
+			std::vector<unsigned char> latin1;
+			while(latin1.size() < n)
+			{
+				std::size_t const run = 1 + gen() % (round < 4? 80 : 4);
+				unsigned const kind = gen() % 2;
+				for(std::size_t i = 0; i < run && latin1.size() < n; ++i)
+				{
+					latin1.push_back(static_cast<unsigned char>(kind? 0x80u | gen() : gen() & 0x7Fu));
+				}
+			}
+			check("count_high", k.name, n, k.count_high(latin1.data(), n), LB::utf::scalar::count_high(latin1.data(), n));
+
+			std::size_t const size = n + LB::utf::scalar::count_high(latin1.data(), n);
+			std::vector<unsigned char> utf8 (size + 64, 0xFFu), expected_utf8 (size + 64, 0xFFu);
+			check("latin1_to_utf8", k.name, n, k.latin1_to_utf8(latin1.data(), n, utf8.data()), LB::utf::scalar::latin1_to_utf8(latin1.data(), n, expected_utf8.data()));
+			check("latin1_to_utf8 output", k.name, n, utf8 == expected_utf8, true);
+
+			utf8.resize(size);
+			if(round % 2 && size)
+			{
+				//a sequence the kernels leave to the caller, such as a longer one or a stray continuation
+				std::size_t const at = gen() % size;
+				static unsigned char const others[] = {0xE6u, 0xC1u, 0x80u, 0xC3u, 0xFFu};
+				utf8[at] = others[gen() % 5];
+			}
+			std::vector<unsigned char> back (size + 64, 0xFFu), expected_back (size + 64, 0xFFu);
+			auto const r = k.utf8_to_latin1(utf8.data(), size, back.data());
+			auto const e = LB::utf::scalar::utf8_to_latin1(utf8.data(), size, expected_back.data());
+			check("utf8_to_latin1 read", k.name, size, r.read, e.read);
+			check("utf8_to_latin1 written", k.name, size, r.written, e.written);
+			check("utf8_to_latin1 output", k.name, size, back == expected_back, true);
+			if(round % 2 == 0)
+			{
+				check("utf8_to_latin1 round trip", k.name, size, e.read == size && std::equal(latin1.begin(), latin1.end(), expected_back.begin()), true);
+			}
+		}
+	}
+}
+
+void run_kernel_tests(LB::utf::simd::kernels const &k)
+{
+	std::cout << "Kernels: " << k.name << std::endl;
+	std::mt19937 gen {42};
+	for(std::size_t n = 0; n < 300; ++n)
+	{
+		for(int round = 0; round < 4; ++round)
+		{
+			std::vector<unsigned char> v (n);
+			for(auto &cu : v)
+			{
+				cu = static_cast<unsigned char>(gen() & 0x7Fu);
+			}
+			if(round && n)
+			{
+				//plant a non-ASCII code unit somewhere, with a random header
+				v[gen() % n] = static_cast<unsigned char>(0x80u | gen());
+			}
+			if(round == 3)
+			{
+				for(auto &cu : v)
+				{
+					cu = static_cast<unsigned char>(gen());
+				}
+			}
+			check("ascii_prefix", k.name, n, k.ascii_prefix(v.data(), n), LB::utf::scalar::ascii_prefix(v.data(), n));
+			check("count_leads", k.name, n, k.count_leads(v.data(), n), LB::utf::scalar::count_leads(v.data(), n));
+			for(std::size_t offset : {std::size_t{0}, std::size_t{1}, std::size_t{3}, std::size_t{17}})
+			{
+				unsigned char const a = static_cast<unsigned char>(gen()), b = static_cast<unsigned char>(gen());
+				if(n > offset && round)
+				{
+					std::size_t const at = gen() % (n - offset);
+					v[at] = a;
+					v[at + offset] = b;
+				}
+				check("find_pair", k.name, n, k.find_pair(v.data(), n, a, b, offset), LB::utf::scalar::find_pair(v.data(), n, a, b, offset));
+			}
+			LB::utf::simd::byte_set set {};
+			for(int i = 0; i < round*3; ++i)
+			{
+				set.insert(static_cast<unsigned char>(gen()));
+			}
+			set.insert(static_cast<unsigned char>(0x80u | gen()));
+			check("find_in_set", k.name, n, k.find_in_set(v.data(), n, set), LB::utf::scalar::find_in_set(v.data(), n, set));
+
+			std::vector<std::uint32_t> wide (n, 0xFFFFFFFFu), expected_wide (n, 0xFFFFFFFFu);
+			check("widen_ascii", k.name, n, k.widen_ascii(v.data(), n, wide.data()), LB::utf::scalar::widen_ascii(v.data(), n, expected_wide.data()));
+			check("widen_ascii output", k.name, n, wide == expected_wide, true);
+			for(std::size_t i = 0; i < n; ++i)
+			{
+				wide[i] = v[i];
+			}
+			if(round == 2 && n)
+			{
+				//a value which only differs from ASCII in its upper bits
+				wide[gen() % n] = 0x00010041u;
+			}
+			std::vector<unsigned char> narrow (n, 0xFFu), expected_narrow (n, 0xFFu);
+			check("narrow_ascii", k.name, n, k.narrow_ascii(wide.data(), n, narrow.data()), LB::utf::scalar::narrow_ascii(wide.data(), n, expected_narrow.data()));
+			check("narrow_ascii output", k.name, n, narrow == expected_narrow, true);
+
+			std::vector<unsigned char> copy (n, 0xFFu), expected_copy (n, 0xFFu);
+			check("copy_ascii", k.name, n, k.copy_ascii(v.data(), n, copy.data()), LB::utf::scalar::copy_ascii(v.data(), n, expected_copy.data()));
+			check("copy_ascii output", k.name, n, copy == expected_copy, true);
+			check("count_high", k.name, n, k.count_high(v.data(), n), LB::utf::scalar::count_high(v.data(), n));
+
+			//the terminated kernels must agree at every alignment, and stop at the first zero
+			for(std::size_t offset : {std::size_t{0}, std::size_t{1}, std::size_t{15}, std::size_t{33}, std::size_t{63}})
+			{
+				std::vector<unsigned char> z (offset + n + 1, 0xFFu);
+				std::copy(v.begin(), v.end(), z.begin() + static_cast<std::ptrdiff_t>(offset));
+				z[offset + n] = 0;
+				if(round == 1 && n)
+				{
+					z[offset + gen() % n] = 0;
+				}
+				unsigned char const *const p = z.data() + offset;
+				check("ascii_prefix_terminated", k.name, n, k.ascii_prefix_terminated(p), LB::utf::scalar::ascii_prefix_terminated(p));
+				check("count_leads_terminated", k.name, n, k.count_leads_terminated(p), LB::utf::scalar::count_leads_terminated(p));
+			}
+		}
+	}
+	//exercise the accumulator flush in the counting kernels
+	std::vector<unsigned char> big (100000, 0xBFu);
+	for(std::size_t i = 0; i < big.size(); i += 3)
+	{
+		big[i] = 'a';
+	}
+	check("count_leads", k.name, big.size(), k.count_leads(big.data(), big.size()), LB::utf::scalar::count_leads(big.data(), big.size()));
+	check("count_high", k.name, big.size(), k.count_high(big.data(), big.size()), LB::utf::scalar::count_high(big.data(), big.size()));
+	big.push_back(0);
+	check("count_leads_terminated", k.name, big.size(), k.count_leads_terminated(big.data()), LB::utf::scalar::count_leads(big.data(), big.size() - 1));
+#ifdef __unix__
+	{
+		//strings which end right before an inaccessible page must not fault
+		long const page = sysconf(_SC_PAGESIZE);
+		void *const mem = mmap(nullptr, static_cast<std::size_t>(page)*2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(mem != MAP_FAILED && mprotect(static_cast<char *>(mem) + page, static_cast<std::size_t>(page), PROT_NONE) == 0)
+		{
+			unsigned char *const end = static_cast<unsigned char *>(mem) + page;
+			for(std::size_t n = 0; n < 200; ++n)
+			{
+				unsigned char *const p = end - n - 1;
+				std::fill(p, end - 1, static_cast<unsigned char>(n % 2? 'a' : 0xC3u));
+				end[-1] = 0;
+				check("ascii_prefix_terminated at a page end", k.name, n, k.ascii_prefix_terminated(p), n % 2? n : 0);
+				check("count_leads_terminated at a page end", k.name, n, k.count_leads_terminated(p), n);
+			}
+		}
+		if(mem != MAP_FAILED)
+		{
+			munmap(mem, static_cast<std::size_t>(page)*2);
+		}
+	}
+#endif
+	run_wide_tests(k, k.single_prefix16, k.count_leads16, "16-bit code units");
+	run_wide_tests(k, k.single_prefix32, k.count_leads32, "32-bit code units");
+	run_wide_tests(k, k.single_prefix64, k.count_leads64, "64-bit code units");
+	run_latin1_tests(k);
+	for(unsigned b = 0; b < 256; ++b)
+	{
+		//every member of a single element set must be found exactly
+		LB::utf::simd::byte_set set {};
+		set.insert(static_cast<unsigned char>(b));
+		std::vector<unsigned char> all (256);
+		for(unsigned i = 0; i < 256; ++i)
+		{
+			all[i] = static_cast<unsigned char>(255 - i);
+		}
+		check("find_in_set", k.name, all.size(), k.find_in_set(all.data(), all.size(), set), 255 - b);
+	}
+}
+
+int main()
+{
+	for(char const *const name : {"scalar", "sse2", "avx2", "avx512"})
+	{
+		if(auto const k = LB::utf::simd::find_kernels(name))
+		{
+			run_kernel_tests(*k);
+		}
+		else
+		{
+			std::cout << "Kernels not available: " << name << std::endl;
+		}
+	}
+	std::cout << "Active kernels: " << LB::utf::simd::active().name << std::endl;
+
+	std::cout << "Bulk operations" << std::endl;
+	std::string str;
+	std::u32string wide;
+	for(std::uint32_t cp = 0; cp < 0x2000; cp += 7)
+	{
+		str += LB::utf::encode_code_point<char>(cp);
+		wide += LB::utf::encode_code_point<char32_t>(cp);
+	}
+	str += LB::utf::encode_code_point<char>(std::uintmax_t{1} << 40);
+	std::size_t const expected = 0x2000/7 + 2;
+	check("count_code_points", "contiguous", str.size(), LB::utf::count_code_points(str.data(), str.data() + str.size()), expected);
+	check("count_code_points", "iterator", wide.size(), LB::utf::count_code_points(std::cbegin(wide), std::cend(wide)), expected - 1);
+	check("validate", "contiguous", str.size(), static_cast<std::size_t>(LB::utf::validate(std::cbegin(str), std::cend(str)) - std::cbegin(str)), str.size());
+	auto const truncated = str.substr(0, str.size() - 1);
+	auto const bad = truncated.size() - (LB::utf::min_code_units<char>(std::uintmax_t{1} << 40) - 1);
+	check("validate", "truncated", truncated.size(), static_cast<std::size_t>(LB::utf::validate(std::cbegin(truncated), std::cend(truncated)) - std::cbegin(truncated)), bad);
+
+	{
+		//wider code units go through the same kernels, including code points that take several of them
+		std::u16string wide16;
+		std::vector<std::uint64_t> wide64;
+		for(std::uint64_t cp = 0; cp < 0x30000; cp += 13)
+		{
+			LB::utf::encode_code_point<char16_t>(cp, std::back_inserter(wide16));
+			LB::utf::encode_code_point<std::uint64_t>(cp << 40, std::back_inserter(wide64));
+		}
+		std::size_t const count = (0x30000 + 12)/13;
+		check("count_code_points", "16-bit", wide16.size(), LB::utf::count_code_points(std::cbegin(wide16), std::cend(wide16)), count);
+		check("validate", "16-bit", wide16.size(), static_cast<std::size_t>(LB::utf::validate(std::cbegin(wide16), std::cend(wide16)) - std::cbegin(wide16)), wide16.size());
+		check("count_code_points", "64-bit", wide64.size(), LB::utf::count_code_points(wide64.data(), wide64.data() + wide64.size()), count);
+		check("validate", "64-bit", wide64.size(), static_cast<std::size_t>(LB::utf::validate(wide64.data(), wide64.data() + wide64.size()) - wide64.data()), wide64.size());
+		wide16.pop_back();
+		check("validate", "truncated 16-bit", wide16.size(), static_cast<std::size_t>(LB::utf::validate(std::cbegin(wide16), std::cend(wide16)) - std::cbegin(wide16)), wide16.size() - 1);
+		std::u32string invalid32 (100, U'a');
+		invalid32[60] = 0x80000000u;
+		check("validate", "invalid 32-bit", invalid32.size(), static_cast<std::size_t>(LB::utf::validate(std::cbegin(invalid32), std::cend(invalid32)) - std::cbegin(invalid32)), 60);
+	}
+
+	return result;
+}
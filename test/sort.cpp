@@ -0,0 +1,98 @@
+#include "sort.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, bool ok)
+{
+	if(!ok)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << std::endl;
+	}
+}
+
+//keys sharing prefixes, mostly canonical, some with overlong or invalid sequences
+template<typename code_unit_t>
+auto random_keys(std::mt19937 &gen, std::size_t const n, bool const canonical)
+-> std::vector<std::basic_string<code_unit_t>>
+{
+	using unsigned_t = std::make_unsigned_t<code_unit_t>;
+	std::vector<std::basic_string<code_unit_t>> keys;
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		std::basic_string<code_unit_t> key;
+		for(std::size_t length = gen() % 8; length; --length)
+		{
+			switch(gen() % (canonical? 3 : 5))
+			{
+				case 0: key += static_cast<code_unit_t>('a' + gen() % 4); break;
+				case 1: LB::utf::encode_code_point<code_unit_t>(0x80u + gen() % 0x300u, std::back_inserter(key)); break;
+				case 2: LB::utf::encode_code_point<code_unit_t>(std::uintmax_t{gen()} << (gen() % 32), std::back_inserter(key)); break;
+				case 3:
+				{
+					//'a' as a sequence of two code units
+					key += static_cast<code_unit_t>(~(~unsigned_t{} >> 2));
+					key += static_cast<code_unit_t>((unsigned_t{1} << (sizeof(unsigned_t)*8 - 1)) | 'a');
+					break;
+				}
+				default: key += static_cast<code_unit_t>(gen()); break;
+			}
+		}
+		keys.push_back(key);
+	}
+	return keys;
+}
+
+template<typename code_unit_t>
+void run_tests(char const *const what, std::size_t const n, bool const canonical)
+{
+	std::mt19937 gen {static_cast<std::mt19937::result_type>(n)};
+	auto keys = random_keys<code_unit_t>(gen, n, canonical);
+	auto sorted = keys;
+	LB::utf::sort_code_point_order(std::begin(sorted), std::end(sorted));
+
+	bool ordered = true;
+	for(std::size_t i = 1; i < sorted.size(); ++i)
+	{
+		ordered = ordered && LB::utf::compare(std::cbegin(sorted[i - 1]), std::cend(sorted[i - 1]), std::cbegin(sorted[i]), std::cend(sorted[i])) <= 0;
+	}
+	check(std::string(what) + " ordered", ordered);
+	std::sort(std::begin(keys), std::end(keys));
+	std::sort(std::begin(sorted), std::end(sorted));
+	check(std::string(what) + " permutation", keys == sorted);
+}
+
+int main()
+{
+	//small inputs only take the insertion sort, large ones split into buckets several times
+	for(std::size_t const n : {0, 1, 2, 31, 1000, 50000})
+	{
+		run_tests<char>("8-bit canonical", n, true);
+		run_tests<char>("8-bit mixed", n, false);
+		run_tests<char16_t>("16-bit mixed", n, false);
+		run_tests<char32_t>("32-bit canonical", n, true);
+		run_tests<std::uint64_t>("64-bit mixed", n, false);
+	}
+
+	{
+		//code point order, not the order of the code units as signed char
+		std::vector<std::string> keys {"\xC3\xA9", "z", "", "\xE6\x97\xA5", "a", "\xC3\xA9t\xC3\xA9", "\x80"};
+		LB::utf::sort_code_point_order(std::begin(keys), std::end(keys));
+		check("fixed order", keys == std::vector<std::string>{"", "a", "z", "\xC3\xA9", "\xC3\xA9t\xC3\xA9", "\xE6\x97\xA5", "\x80"});
+
+		std::vector<std::vector<unsigned char>> vectors {{'b'}, {0xC3, 0xA9}, {'a', 'b'}};
+		LB::utf::sort_code_point_order(std::begin(vectors), std::end(vectors));
+		check("vectors", vectors == std::vector<std::vector<unsigned char>>{{'a', 'b'}, {'b'}, {0xC3, 0xA9}});
+	}
+
+	return result;
+}
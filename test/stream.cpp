@@ -0,0 +1,203 @@
+#include "stream.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+//a sink whose writes throw, like a streambuf with exceptions enabled
+struct throwing_sink final
+{
+	auto write(void const *, std::size_t)
+	-> bool
+	{
+		throw std::runtime_error("write failed");
+	}
+};
+
+using decoded_t = std::vector<std::tuple<std::size_t, std::uintmax_t>>;
+
+//what read_code_point gives when the whole input is in memory
+template<typename code_unit_t>
+auto expected(std::basic_string<code_unit_t> const &str)
+-> decoded_t
+{
+	decoded_t r;
+	for(auto it = std::cbegin(str), end = std::cend(str); it != end; )
+	{
+		std::uintmax_t cp {};
+		auto const n = LB::utf::read_code_point(it, end, cp);
+		r.emplace_back(n.second, n.second? cp : 0);
+		it = n.second? n.first : std::next(it);
+	}
+	return r;
+}
+
+template<typename reader_t>
+auto decode(reader_t &&reader)
+-> decoded_t
+{
+	decoded_t r;
+	while(!reader.eof())
+	{
+		std::uintmax_t cp {};
+		auto const n = reader.read(cp);
+		r.emplace_back(n, n? cp : 0);
+	}
+	return r;
+}
+
+void check(char const *what, std::size_t block_size, decoded_t const &output, decoded_t const &expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " with blocks of " << block_size << " -> " << output.size() << " results, expected " << expected.size() << std::endl;
+	}
+}
+
+template<typename code_unit_t>
+auto make_input()
+-> std::basic_string<code_unit_t>
+{
+	std::basic_string<code_unit_t> str;
+	for(std::uintmax_t cp = 1; cp; cp <<= 3)
+	{
+		str += LB::utf::encode_code_point<code_unit_t>(cp);
+		str += LB::utf::encode_code_point<code_unit_t>(cp - 1);
+	}
+	auto const big = LB::utf::encode_code_point<code_unit_t>(~std::uintmax_t{0});
+	str += big.substr(1); //stray continuations
+	str += big.substr(0, big.size()-1); //truncated at the very end
+	return str;
+}
+
+template<typename code_unit_t, typename writer_t>
+void encode(writer_t &&writer)
+{
+	for(std::uintmax_t cp = 1; cp; cp <<= 3)
+	{
+		writer.write(cp);
+		writer.write(cp - 1);
+	}
+	auto const big = LB::utf::encode_code_point<code_unit_t>(~std::uintmax_t{0});
+	writer.write_code_units(std::next(std::cbegin(big)), std::cend(big));
+	writer.write_code_units(std::cbegin(big), std::prev(std::cend(big)));
+}
+
+int main()
+{
+	auto const utf8 = make_input<char>();
+	auto const utf8_expected = expected(utf8);
+	auto const utf16 = make_input<char16_t>();
+	auto const utf16_expected = expected(utf16);
+
+	for(std::size_t block_size : {1, 2, 3, 7, 64, 1 << 16})
+	{
+		std::stringbuf buf {utf8};
+		check("streambuf", block_size, decode(LB::utf::make_reader(buf, block_size)), utf8_expected);
+
+		std::istringstream in {std::string(reinterpret_cast<char const *>(utf16.data()), utf16.size()*sizeof(char16_t))};
+		check("16-bit istream", block_size, decode(LB::utf::make_reader<char16_t>(in, block_size)), utf16_expected);
+
+		if(std::FILE *const f = std::tmpfile())
+		{
+			std::fwrite(utf8.data(), 1, utf8.size(), f);
+			std::fflush(f);
+			std::rewind(f);
+#ifdef _WIN32
+			int const fd = _fileno(f);
+#else
+			int const fd = fileno(f);
+#endif
+			auto reader = LB::utf::make_fd_reader(fd, block_size);
+			check("file descriptor", block_size, decode(reader), utf8_expected);
+			if(reader.code_units_read() != utf8.size() || reader.source().error)
+			{
+				result = EXIT_FAILURE;
+				std::cout << "Fail: file descriptor read " << reader.code_units_read() << " code units" << std::endl;
+			}
+			std::fclose(f);
+		}
+	}
+
+	for(std::size_t block_size : {1, 2, 3, 7, 64, 1 << 16})
+	{
+		std::stringbuf buf;
+		{
+			auto writer = LB::utf::make_writer(buf, block_size);
+			encode<char>(writer);
+		}
+		if(buf.str() != utf8)
+		{
+			result = EXIT_FAILURE;
+			std::cout << "Fail: streambuf writer with blocks of " << block_size << std::endl;
+		}
+
+		std::ostringstream out;
+		{
+			auto writer = LB::utf::make_writer<char16_t>(out, block_size);
+			encode<char16_t>(writer);
+			if(!writer.flush())
+			{
+				result = EXIT_FAILURE;
+				std::cout << "Fail: 16-bit ostream writer could not flush" << std::endl;
+			}
+		}
+		if(out.str() != std::string(reinterpret_cast<char const *>(utf16.data()), utf16.size()*sizeof(char16_t)))
+		{
+			result = EXIT_FAILURE;
+			std::cout << "Fail: 16-bit ostream writer with blocks of " << block_size << std::endl;
+		}
+
+		if(std::FILE *const f = std::tmpfile())
+		{
+#ifdef _WIN32
+			int const fd = _fileno(f);
+#else
+			int const fd = fileno(f);
+#endif
+			encode<char>(LB::utf::make_fd_writer(fd, block_size));
+			std::rewind(f);
+			std::string contents (utf8.size() + 1, '\0');
+			contents.resize(std::fread(&contents[0], 1, contents.size(), f));
+			if(contents != utf8)
+			{
+				result = EXIT_FAILURE;
+				std::cout << "Fail: file descriptor writer with blocks of " << block_size << std::endl;
+			}
+			std::fclose(f);
+		}
+	}
+
+	//destroying a writer while unwinding must not let the sink throw again
+	try
+	{
+		LB::utf::writer<throwing_sink> writer {throwing_sink{}};
+		writer.write(U'a');
+		throw std::logic_error("unwinding");
+	}
+	catch(std::logic_error const &)
+	{
+	}
+	try
+	{
+		LB::utf::writer<throwing_sink> writer {throwing_sink{}};
+		writer.write(U'a');
+		writer.flush();
+		result = EXIT_FAILURE;
+		std::cout << "Fail: explicit flush swallowed the sink's exception" << std::endl;
+	}
+	catch(std::runtime_error const &)
+	{
+	}
+
+	return result;
+}
@@ -0,0 +1,176 @@
+#include "transcode.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(char const *what, std::size_t from, std::size_t to, bool ok)
+{
+	if(!ok)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " from " << from*8 << "-bit to " << to*8 << "-bit" << std::endl;
+	}
+}
+
+template<typename code_unit_t>
+auto encode(std::vector<std::uintmax_t> const &cps)
+-> std::basic_string<code_unit_t>
+{
+	std::basic_string<code_unit_t> str;
+	for(auto const cp : cps)
+	{
+		LB::utf::encode_code_point<code_unit_t>(cp, std::back_inserter(str));
+	}
+	return str;
+}
+
+template<typename from_unit_t, typename to_unit_t>
+void run_tests(std::vector<std::uintmax_t> const &cps)
+{
+	auto const in = encode<from_unit_t>(cps);
+	auto const expected = encode<to_unit_t>(cps);
+	constexpr std::size_t from = sizeof(from_unit_t), to = sizeof(to_unit_t);
+
+	check("transcoded_size", from, to, LB::utf::transcoded_size<to_unit_t>(std::cbegin(in), std::cend(in)) == expected.size());
+	check("string", from, to, LB::utf::transcode<to_unit_t>(std::cbegin(in), std::cend(in)) == expected);
+
+	//the pointer output is what the kernels write to
+	std::vector<to_unit_t> out (expected.size() + 1, to_unit_t{1});
+	auto const r = LB::utf::transcode<to_unit_t>(in.data(), in.data() + in.size(), out.data());
+	check("pointers", from, to, r.in == in.data() + in.size() && r.out == out.data() + expected.size() && std::basic_string<to_unit_t>(out.data(), expected.size()) == expected && out.back() == to_unit_t{1});
+
+	std::list<from_unit_t> const list (std::cbegin(in), std::cend(in));
+	std::basic_string<to_unit_t> generic;
+	check("iterators", from, to, LB::utf::transcode<to_unit_t>(std::cbegin(list), std::cend(list), std::back_inserter(generic)).in == std::cend(list) && generic == expected);
+	check("iterators transcoded_size", from, to, LB::utf::transcoded_size<to_unit_t>(std::cbegin(list), std::cend(list)) == expected.size());
+
+	//every width is measured at once, whatever the source width
+	auto const sizes = LB::utf::encoded_sizes(std::cbegin(in), std::cend(in));
+	auto const matches = [&](LB::utf::encoded_size const &s, std::vector<std::uintmax_t> const &of)
+	{
+		return s.units8 == encode<std::uint8_t>(of).size() && s.units16 == encode<std::uint16_t>(of).size() && s.units32 == encode<std::uint32_t>(of).size() && s.units64 == encode<std::uint64_t>(of).size();
+	};
+	check("encoded_sizes", from, to, matches(sizes, cps));
+	check("encoded_sizes iterators", from, to, matches(LB::utf::encoded_sizes(std::cbegin(list), std::cend(list)), cps));
+	check("encoded_sizes_of_code_points", from, to, matches(LB::utf::encoded_sizes_of_code_points(std::cbegin(cps), std::cend(cps)), cps));
+
+	std::vector<from_unit_t> copy (in.size() + 1, from_unit_t{1});
+	auto const c = LB::utf::copy_validated(in.data(), in.data() + in.size(), copy.data());
+	check("copy_validated", from, from, c.in == in.data() + in.size() && c.out == copy.data() + in.size() && std::basic_string<from_unit_t>(copy.data(), in.size()) == in && copy.back() == from_unit_t{1});
+	std::basic_string<from_unit_t> generic_copy;
+	check("copy_validated iterators", from, from, LB::utf::copy_validated(std::cbegin(list), std::cend(list), std::back_inserter(generic_copy)).in == std::cend(list) && generic_copy == in);
+
+	//invalid input stops at the invalid sequence, after transcoding everything before it
+	//dropping the last code unit only makes the input invalid when it cuts a sequence short
+	if(in.size() < 2 || LB::utf::num_code_units(std::cbegin(in) + static_cast<std::ptrdiff_t>(in.size() - 1), std::cend(in)) == 1)
+	{
+		return;
+	}
+	auto truncated = in;
+	truncated.pop_back();
+	std::basic_string<to_unit_t> partial;
+	auto const stopped = LB::utf::transcode<to_unit_t>(std::cbegin(truncated), std::cend(truncated), std::back_inserter(partial)).in;
+	std::vector<std::uintmax_t> const most (std::cbegin(cps), std::cend(cps) - 1);
+	check("invalid stops", from, to, stopped == std::cbegin(truncated) + static_cast<std::ptrdiff_t>(encode<from_unit_t>(most).size()) && partial == encode<to_unit_t>(most));
+	check("invalid transcoded_size", from, to, LB::utf::transcoded_size<to_unit_t>(std::cbegin(truncated), std::cend(truncated)) == partial.size());
+	check("invalid encoded_sizes", from, to, matches(LB::utf::encoded_sizes(std::cbegin(truncated), std::cend(truncated)), most));
+	std::vector<from_unit_t> partial_copy (truncated.size());
+	auto const pc = LB::utf::copy_validated(truncated.data(), truncated.data() + truncated.size(), partial_copy.data());
+	check("invalid copy_validated", from, from, pc.in == truncated.data() + (stopped - std::cbegin(truncated)) && std::basic_string<from_unit_t>(partial_copy.data(), pc.out) == encode<from_unit_t>(most));
+	bool threw = false;
+	try
+	{
+		LB::utf::transcode<to_unit_t>(std::cbegin(truncated), std::cend(truncated));
+	}
+	catch(std::invalid_argument const &)
+	{
+		threw = true;
+	}
+	check("invalid throws", from, to, threw);
+}
+
+template<typename from_unit_t, typename to_unit_t>
+void run_all()
+{
+	std::vector<std::uintmax_t> cps;
+	for(std::uintmax_t i = 0; i < 300; ++i)
+	{
+		cps.push_back('a' + i%26);
+	}
+	run_tests<from_unit_t, to_unit_t>(cps);
+	//a code point which needs an extended sequence at every width, after a long run of ASCII
+	cps.push_back(std::uintmax_t{1} << 40);
+	run_tests<from_unit_t, to_unit_t>(cps);
+	for(std::uintmax_t cp = 1; cp; cp <<= 1)
+	{
+		cps.push_back(cp);
+		cps.push_back(cp - 1);
+		cps.push_back('x');
+	}
+	run_tests<from_unit_t, to_unit_t>(cps);
+	run_tests<from_unit_t, to_unit_t>({});
+	run_tests<from_unit_t, to_unit_t>({0xE9});
+}
+
+int main()
+{
+	run_all<char, char32_t>();
+	run_all<char32_t, char>();
+	//std::uint32_t is what the kernels take, other 32-bit types are copied through a buffer
+	run_all<char, std::uint32_t>();
+	run_all<std::uint32_t, char>();
+	run_all<char, char16_t>();
+	run_all<char16_t, char>();
+	run_all<char16_t, char32_t>();
+	run_all<char32_t, std::uint32_t>();
+	run_all<char, char>();
+	run_all<std::uint64_t, unsigned char>();
+
+	{
+		//the copy stops in the middle, after a valid sequence and before the stray continuation
+		std::string const in = std::string(100, 'a') + "\xC3\xA9\x80" + std::string(100, 'b');
+		std::string out (in.size(), '\0');
+		auto const r = LB::utf::copy_validated(in.data(), in.data() + in.size(), &out[0]);
+		check("copy_validated stops", 1, 1, r.in == in.data() + 102 && r.out == &out[0] + 102 && out.compare(0, 102, in, 0, 102) == 0 && out[102] == '\0');
+	}
+
+	{
+		//a valid sequence for a value wider than std::uintmax_t stops it like an invalid one:
+		//13 8-bit code units hold 67 bits, here 2^66
+		std::string wide = "a\xFF\xBD";
+		wide.append(11, '\x80');
+		wide += 'b';
+		check("wider than std::uintmax_t is valid", 1, 4, LB::utf::num_code_units(std::cbegin(wide) + 1, std::cend(wide)) == 13);
+		std::u32string out (wide.size(), U'\0');
+		auto const r = LB::utf::transcode<char32_t>(wide.data(), wide.data() + wide.size(), &out[0]);
+		check("wider than std::uintmax_t stops", 1, 4, r.in == wide.data() + 1 && r.out == &out[0] + 1 && out[0] == U'a');
+		check("wider than std::uintmax_t transcoded_size", 1, 4, LB::utf::transcoded_size<char32_t>(std::cbegin(wide), std::cend(wide)) == 1);
+		bool threw = false;
+		try
+		{
+			LB::utf::transcode<char32_t>(std::cbegin(wide), std::cend(wide));
+		}
+		catch(std::invalid_argument const &)
+		{
+			threw = true;
+		}
+		check("wider than std::uintmax_t throws", 1, 4, threw);
+	}
+
+	{
+		//code points of narrower unsigned types
+		std::vector<std::uint16_t> const small {'a', 0x7F, 0x80, 0x7FFF, 0x8000};
+		auto const s = LB::utf::encoded_sizes_of_code_points(std::cbegin(small), std::cend(small));
+		check("encoded_sizes_of_code_points std::uint16_t", 1, 2, s.units8 == 1 + 1 + 2 + 3 + 3 && s.units16 == 4 + 2 && s.units32 == 5 && s.units64 == 5);
+	}
+
+	return result;
+}
@@ -0,0 +1,92 @@
+#include "buffer.hpp"
+#include "utf.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+using decoded_t = std::vector<std::tuple<std::size_t, std::size_t, std::uintmax_t>>;
+
+//decodes every position, recording the results of num_code_units with verification and read_code_point
+template<typename code_unit_iterator>
+auto decode(code_unit_iterator const first, code_unit_iterator const last)
+-> decoded_t
+{
+	decoded_t r;
+	for(auto it = first; it != last; ++it)
+	{
+		std::uintmax_t cp {};
+		auto const n = LB::utf::read_code_point(it, last, cp).second;
+		r.emplace_back(LB::utf::num_code_units(it, last, true), n, n? cp : 0);
+	}
+	return r;
+}
+
+template<typename code_unit_t>
+auto decode_unchecked(LB::utf::padded_buffer<code_unit_t> const &buffer)
+-> decoded_t
+{
+	decoded_t r;
+	for(auto it = buffer.begin(); it != buffer.end(); ++it)
+	{
+		std::uintmax_t cp {};
+		auto const n = LB::utf::unchecked::read_code_point(it, cp).second;
+		r.emplace_back(LB::utf::unchecked::num_code_units(it, true), n, n? cp : 0);
+	}
+	return r;
+}
+
+void check(char const *what, decoded_t const &output, decoded_t const &expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << std::endl;
+	}
+}
+
+template<typename code_unit_t>
+void run_tests()
+{
+	//valid sequences of every length, cut up and shuffled so every kind of error and truncation occurs
+	std::basic_string<code_unit_t> valid;
+	for(std::uintmax_t cp = 1; cp; cp <<= 1)
+	{
+		valid += LB::utf::encode_code_point<code_unit_t>(cp);
+	}
+	std::mt19937 gen {7};
+	for(int round = 0; round < 20; ++round)
+	{
+		auto str = valid;
+		for(int i = 0; i < round; ++i)
+		{
+			std::swap(str[gen() % str.size()], str[gen() % str.size()]);
+		}
+		str.resize(str.size() - gen() % 20);
+
+		std::list<code_unit_t> const list (std::cbegin(str), std::cend(str));
+		auto const expected = decode(std::cbegin(list), std::cend(list));
+		check("contiguous", decode(std::cbegin(str), std::cend(str)), expected);
+		check("pointers", decode(str.data(), str.data() + str.size()), expected);
+
+		//the unchecked functions cannot tell truncation from an invalid continuation, but the results are otherwise the same
+		LB::utf::padded_buffer<code_unit_t> const buffer (std::cbegin(str), std::cend(str));
+		check("padded_buffer", decode_unchecked(buffer), expected);
+	}
+}
+
+int main()
+{
+	run_tests<char>();
+	run_tests<char16_t>();
+	run_tests<char32_t>();
+
+	return result;
+}
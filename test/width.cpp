@@ -0,0 +1,105 @@
+#include "width.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+int result = EXIT_SUCCESS;
+
+void check(std::string const &what, std::uint64_t output, std::uint64_t expected)
+{
+	if(output != expected)
+	{
+		result = EXIT_FAILURE;
+		std::cout << "Fail: " << what << " -> " << output << " != " << expected << std::endl;
+	}
+}
+
+template<typename code_unit_iterator>
+void check_extent(std::string const &what, code_unit_iterator const first, code_unit_iterator const last, std::size_t code_points, std::size_t width)
+{
+	auto const e = LB::utf::measure_display(first, last);
+	check(what + " code points", e.code_points, code_points);
+	check(what + " width", e.width, width);
+	check(what + " display_width", LB::utf::display_width(first, last), width);
+}
+
+int main()
+{
+	std::cout << "Code points" << std::endl;
+	for(auto const &t : std::vector<std::pair<std::uint32_t, std::size_t>>
+	{
+		{0x00, 0},
+		{'\n', 0},
+		{0x1F, 0},
+		{' ', 1},
+		{'a', 1},
+		{'~', 1},
+		{0x7F, 0},
+		{0x9F, 0},
+		{0xA0, 1},
+		{0xAD, 1},       //soft hyphen
+		{0xE9, 1},
+		{0x0301, 0},     //combining acute accent
+		{0x0488, 0},     //enclosing mark
+		{0x0903, 1},     //spacing mark
+		{0x1100, 2},     //Hangul choseong
+		{0x1160, 0},     //Hangul jungseong
+		{0x200B, 0},     //zero width space
+		{0x200D, 0},     //zero width joiner
+		{0x3000, 2},     //ideographic space
+		{0x4E00, 2},
+		{0xAC00, 2},     //Hangul syllable
+		{0xD7B0, 0},
+		{0xFE0F, 0},     //variation selector
+		{0xFF21, 2},     //fullwidth A
+		{0xFF61, 1},     //halfwidth ideographic full stop
+		{0x1F600, 2},    //emoji
+		{0x20000, 2},
+		{0x2FFFD, 2},    //unassigned but wide by default
+		{0xE0001, 0},    //language tag
+		{0x10FFFF, 1},
+		{0x110000, 1},
+		{0xFFFFFFFF, 1},
+	})
+	{
+		check("width of " + std::to_string(t.first), LB::utf::width(t.first), t.second);
+	}
+	check("width of std::uintmax_t", LB::utf::width(std::uintmax_t{1} << 40), 1);
+
+	std::cout << "Strings" << std::endl;
+	{
+		std::string const ascii = "hello, world";
+		check_extent("ASCII", std::cbegin(ascii), std::cend(ascii), ascii.size(), ascii.size());
+		std::string const empty;
+		check_extent("empty", std::cbegin(empty), std::cend(empty), 0, 0);
+		std::string const tab = "a\tb\n";
+		check_extent("controls", std::cbegin(tab), std::cend(tab), 4, 2);
+
+		//e + combining acute, two CJK, an emoji, then ASCII again
+		std::string const mixed = "e\xCC\x81\xE6\x97\xA5\xE6\x9C\xAC\xF0\x9F\x98\x80!";
+		check_extent("mixed", std::cbegin(mixed), std::cend(mixed), 6, 1 + 0 + 2 + 2 + 2 + 1);
+		std::list<char> const list (std::cbegin(mixed), std::cend(mixed));
+		check_extent("mixed list", std::cbegin(list), std::cend(list), 6, 8);
+
+		std::string const invalid = "a\x80\xC3" "b";
+		check_extent("invalid", std::cbegin(invalid), std::cend(invalid), 4, 4);
+
+		//long enough to go through the vector loops on both sides of a wide character
+		std::string const padded = std::string(100, 'x') + "\xE4\xB8\x80" + std::string(100, 'y');
+		check_extent("padded", std::cbegin(padded), std::cend(padded), 201, 202);
+
+		std::u16string wide;
+		for(std::uint32_t const cp : {0x41u, 0x4E00u, 0x0301u, 0x1F600u})
+		{
+			wide += LB::utf::encode_code_point<char16_t>(cp);
+		}
+		check_extent("16-bit", std::cbegin(wide), std::cend(wide), 4, 1 + 2 + 0 + 2);
+	}
+
+	return result;
+}
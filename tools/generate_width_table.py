@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# Generates src/width_table.hpp, the display width of every code point up to U+10FFFF.
+# Uses the Unicode database of the Python running it, so nothing is fetched:
+#   python3 tools/generate_width_table.py > src/width_table.hpp
+#
+# Widths follow the usual terminal conventions:
+#   0 for control characters, combining marks (Mn, Me), format characters (Cf) other than U+00AD,
+#     and Hangul Jamo vowels and final consonants, which join onto the preceding syllable
+#   2 for East Asian Wide (W) and Fullwidth (F), which include emoji with default emoji presentation
+#   1 for everything else, including unassigned code points outside the ranges that default to wide
+
+import sys
+import unicodedata
+
+BLOCK_BITS = 8
+BLOCK_SIZE = 1 << BLOCK_BITS
+END = 0x110000
+# unassigned code points in these ranges default to East Asian Wide
+UNASSIGNED_WIDE = [(0x3400, 0x4DBF), (0x4E00, 0x9FFF), (0xF900, 0xFAFF), (0x20000, 0x2FFFD), (0x30000, 0x3FFFD)]
+
+
+def width(cp):
+	if 0x1160 <= cp <= 0x11FF or 0xD7B0 <= cp <= 0xD7FF:
+		return 0
+	c = chr(cp)
+	category = unicodedata.category(c)
+	if category in ('Cc', 'Mn', 'Me') or (category == 'Cf' and cp != 0xAD):
+		return 0
+	if category == 'Cn':
+		# Python reports every unassigned code point as F, so use the defaults from EastAsianWidth.txt
+		return 2 if any(first <= cp <= last for first, last in UNASSIGNED_WIDE) else 1
+	if unicodedata.east_asian_width(c) in ('W', 'F'):
+		return 2
+	return 1
+
+
+def pack(widths):
+	# 2 bits per code point, 4 per byte, lowest code point in the lowest bits
+	return bytes(sum(w << (2*j) for j, w in enumerate(widths[i:i + 4])) for i in range(0, len(widths), 4))
+
+
+def rows(values, per_row):
+	for i in range(0, len(values), per_row):
+		yield '\t\t\t\t\t' + ', '.join('0x%02X' % v for v in values[i:i + per_row]) + ','
+
+
+def main():
+	blocks = []
+	index = {}
+	stage1 = []
+	for start in range(0, END, BLOCK_SIZE):
+		block = pack([width(cp) for cp in range(start, start + BLOCK_SIZE)])
+		if block not in index:
+			index[block] = len(blocks)
+			blocks.append(block)
+		stage1.append(index[block])
+	if len(blocks) > 256:
+		sys.exit('too many distinct blocks for 8-bit indices')
+	stage2 = b''.join(blocks)
+
+	out = sys.stdout
+	out.write('''#ifndef LB_utf_width_table_HeaderPlusPlus
+#define LB_utf_width_table_HeaderPlusPlus
+
+//generated by tools/generate_width_table.py from Unicode %s, do not edit
+
+#include <cstddef>
+#include <cstdint>
+
+namespace LB
+{
+	namespace utf
+	{
+		namespace detail
+		{
+			//each block of width_stage2 holds 1 << width_block_bits code points
+			constexpr std::size_t width_block_bits = %d;
+
+			//for each block of code points up to U+10FFFF, the index of its widths in width_stage2
+			inline auto width_stage1() noexcept
+			-> std::uint8_t const (&)[%d]
+			{
+				static constexpr std::uint8_t table[] =
+				{
+%s
+				};
+				return table;
+			}
+
+			//distinct blocks of widths, 2 bits per code point with the lowest code point in the lowest bits
+			inline auto width_stage2() noexcept
+			-> std::uint8_t const (&)[%d]
+			{
+				static constexpr std::uint8_t table[] =
+				{
+%s
+				};
+				return table;
+			}
+		}
+	}
+}
+
+#endif
+''' % (unicodedata.unidata_version, BLOCK_BITS, len(stage1), '\n'.join(rows(stage1, 32)), len(stage2), '\n'.join(rows(list(stage2), 32))))
+
+
+if __name__ == '__main__':
+	main()